@@ -0,0 +1,173 @@
+// File: backtracker.cpp
+// Purpose: Run a compiled program by backtracking through it, trying each
+//          instruction at each position at most once.
+// Author: Robert Lowe
+#include "backtracker.h"
+
+// static constant definitions
+const size_t Backtracker::DEFAULT_BUDGET_BYTES;
+
+// construct a backtracker to run the program
+Backtracker::Backtracker(const Program *program, size_t budget)
+    : _program(program), _budget(budget), _base(0),
+      _join(program->size(), false) {
+  _join[program->start()] = true;
+  for (int pc = 0; pc < program->size(); pc++) {
+    const Instruction &inst = (*program)[pc];
+    if (inst.op == Instruction::SPLIT) {
+      _join[inst.x] = _join[inst.y] = true;
+    } else if (inst.op == Instruction::JMP) {
+      _join[inst.x] = true;
+    }
+  }
+}
+
+// Return true if the visited set for an input of length bytes fits in the
+// budget. The set has a bit for every instruction at every position, the
+// end of the input included.
+bool Backtracker::fits(size_t length) const {
+  return length < _budget * 8 / _program->size();
+}
+
+// Attempt an anchored match of the string beginning at pos
+bool Backtracker::match(std::string_view str, size_t pos, size_t &end) {
+  int id;
+  return match(str, pos, end, id);
+}
+
+// Attempt an anchored match, also reporting the match id
+bool Backtracker::match(std::string_view str, size_t pos, size_t &end,
+                        int &id) {
+  reset(pos, str.length());
+  return run(str, pos, end, id, false);
+}
+
+// Attempt an anchored match, reporting the capture slots of the longest
+// match.
+bool Backtracker::match(std::string_view str, size_t pos,
+                        std::vector<size_t> &slots) {
+  size_t end;
+  int id;
+
+  reset(pos, str.length());
+  _slots.assign(_program->slots(), std::string_view::npos);
+  if (!run(str, pos, end, id, true)) {
+    return false;
+  }
+
+  slots = _best;
+  slots[0] = pos;
+  slots[1] = end;
+  return true;
+}
+
+// Search for the leftmost-longest match, trying each start in turn
+bool Backtracker::search(std::string_view str, size_t pos, size_t &start,
+                         size_t &end) {
+  int id;
+
+  if (pos > str.length()) {
+    return false;
+  }
+
+  reset(pos, str.length());
+  for (; pos <= str.length(); pos++) {
+    if (run(str, pos, end, id, false)) {
+      start = pos;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// clear the visited set for the positions pos..length of the input
+void Backtracker::reset(size_t pos, size_t length) {
+  size_t words = ((length - pos + 1) * _program->size() + 63) / 64;
+
+  for (auto word : _dirty) {
+    _visited[word] = 0;
+  }
+  _dirty.clear();
+  if (_visited.size() < words) {
+    _visited.resize(words, 0);
+  }
+  _base = pos;
+}
+
+// Explore every path from pos in the order the splits prefer, skipping
+// any instruction already tried at the same position. A path stops at a
+// match instruction, but the exploration goes on, as a longer match may
+// follow.
+bool Backtracker::run(std::string_view str, size_t pos, size_t &end, int &id,
+                      bool captures) {
+  const Program &program = *_program;
+  size_t size = program.size();
+  bool matched = false;
+
+  _examined = pos;
+  _jobs.clear();
+  _jobs.push_back(Job{program.start(), -1, pos});
+
+  while (!_jobs.empty()) {
+    Job job = _jobs.back();
+    _jobs.pop_back();
+
+    if (job.slot >= 0) {
+      _slots[job.slot] = job.pos;
+      continue;
+    }
+
+    // follow the path, pushing the alternatives it passes
+    int pc = job.pc;
+    size_t p = job.pos;
+    for (;;) {
+      if (_join[pc]) {
+        size_t bit = (p - _base) * size + pc;
+        uint64_t &word = _visited[bit / 64];
+        uint64_t mask = (uint64_t)1 << (bit % 64);
+        if (word & mask) {
+          break;
+        }
+        if (!word) {
+          _dirty.push_back(bit / 64);
+        }
+        word |= mask;
+      }
+      if (p + 1 > _examined) {
+        _examined = p + 1;
+      }
+
+      const Instruction &inst = program[pc];
+      if (inst.op == Instruction::SPLIT) {
+        _jobs.push_back(Job{inst.y, -1, p});
+        pc = inst.x;
+      } else if (inst.op == Instruction::JMP) {
+        pc = inst.x;
+      } else if (inst.op == Instruction::SAVE) {
+        if (captures) {
+          _jobs.push_back(Job{0, inst.x, _slots[inst.x]});
+          _slots[inst.x] = p;
+        }
+        pc++;
+      } else if (inst.op == Instruction::MATCH) {
+        if (!matched || p > end || (p == end && inst.x < id)) {
+          if (captures) {
+            _best = _slots;
+          }
+          end = p;
+          id = inst.x;
+        }
+        matched = true;
+        break;
+      } else if (p < str.length() && program.consumes(pc, str[p])) {
+        pc++;
+        p++;
+      } else {
+        break;
+      }
+    }
+  }
+
+  return matched;
+}
@@ -0,0 +1,90 @@
+// File: backtracker.h
+// Purpose: Run a compiled program by backtracking through it, remembering
+//          each instruction and position already tried so that none is
+//          tried twice. The running time is linear in the length of the
+//          input, and the memory is one bit per instruction per position,
+//          which makes it the cheapest engine for short inputs.
+// Author: Robert Lowe
+#ifndef BACKTRACKER_H
+#define BACKTRACKER_H
+#include <cstdint>
+#include <vector>
+#include "matcher.h"
+#include "program.h"
+
+class Backtracker : public Matcher {
+public:
+  // the default memory budget of the visited set
+  static const size_t DEFAULT_BUDGET_BYTES = 256 * 1024;
+
+  // Construct a backtracker to run the program, which must outlive it. The
+  // budget is what fits uses to decide which inputs are short enough.
+  Backtracker(const Program *program, size_t budget = DEFAULT_BUDGET_BYTES);
+
+  // Return true if the visited set for an input of length bytes fits in
+  // the budget. Longer inputs still work, but a Pike VM or a DFA is the
+  // better engine for them.
+  bool fits(size_t length) const;
+
+  // Attempt an anchored match of the string beginning at pos, reporting the
+  // end of the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end);
+
+  // Attempt an anchored match, also reporting the smallest match id among
+  // the program's match instructions accepting the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end,
+                     int &id);
+
+  // Attempt an anchored match, reporting the capture slots of the longest
+  // match. Slots 2i and 2i + 1 receive where group i begins and ends, or
+  // npos if the group took no part in the match. Among the ways of
+  // matching the longest match, the one preferred by the program's splits
+  // gives the slots.
+  bool match(std::string_view str, size_t pos, std::vector<size_t> &slots);
+
+  // Search for the leftmost-longest match. Each start position is tried
+  // in turn, and the visited set is kept between them, as whatever failed
+  // to match from one start fails from the next.
+  virtual bool search(std::string_view str, size_t pos, size_t &start,
+                      size_t &end);
+
+private:
+  const Program *_program;
+  size_t _budget;
+
+  // One bit for each instruction at each position from _base on, and the
+  // words of it which have bits set. Only those words are cleared for the
+  // next run, so a run costs what it explores rather than what is left of
+  // the input.
+  std::vector<uint64_t> _visited;
+  std::vector<size_t> _dirty;
+  size_t _base;
+
+  // Whether each instruction can be reached other than from the one before
+  // it. Only these need the visited set: any other instruction is tried
+  // at most as often as the one before it.
+  std::vector<bool> _join;
+
+  // A job on the backtracking stack: explore from pc at pos, or, if slot
+  // is not negative, put pos back into that capture slot.
+  struct Job {
+    int pc;
+    int slot;
+    size_t pos;
+  };
+  std::vector<Job> _jobs;
+
+  // the capture slots of the path being explored, and of the best match
+  std::vector<size_t> _slots;
+  std::vector<size_t> _best;
+
+  // clear the visited set for the positions pos..length of the input
+  void reset(size_t pos, size_t length);
+
+  // Explore every path from pos, recording the longest match in end and
+  // id, and its slots if captures is set. Returns true if there was one.
+  bool run(std::string_view str, size_t pos, size_t &end, int &id,
+           bool captures);
+};
+
+#endif
@@ -0,0 +1,109 @@
+// File: byte_set.cpp
+// Purpose: A set of bytes stored as a 256-bit bitmap.
+// Author: Robert Lowe
+#include "byte_set.h"
+
+// construct an empty set
+ByteSet::ByteSet() : _bits{0, 0, 0, 0} {}
+
+// add a single byte to the set
+void ByteSet::add(unsigned char c) { _bits[c >> 6] |= uint64_t(1) << (c & 63); }
+
+// add every byte in the range lo..hi to the set
+void ByteSet::add_range(unsigned char lo, unsigned char hi) {
+  for (int c = lo; c <= hi; c++) {
+    add(c);
+  }
+}
+
+// add every member of another set to this set
+void ByteSet::merge(const ByteSet &other) {
+  for (int i = 0; i < 4; i++) {
+    _bits[i] |= other._bits[i];
+  }
+}
+
+// add every byte to the set
+void ByteSet::fill() {
+  for (int i = 0; i < 4; i++) {
+    _bits[i] = ~uint64_t(0);
+  }
+}
+
+// replace the set with its complement
+void ByteSet::invert() {
+  for (int i = 0; i < 4; i++) {
+    _bits[i] = ~_bits[i];
+  }
+}
+
+// return the number of members in the set
+int ByteSet::count() const {
+  int result = 0;
+  for (int i = 0; i < 4; i++) {
+    result += __builtin_popcountll(_bits[i]);
+  }
+  return result;
+}
+
+// return true if the set has no members
+bool ByteSet::empty() const {
+  return (_bits[0] | _bits[1] | _bits[2] | _bits[3]) == 0;
+}
+
+// return true if the set holds every byte
+bool ByteSet::full() const {
+  return (_bits[0] & _bits[1] & _bits[2] & _bits[3]) == ~uint64_t(0);
+}
+
+// If the members form a single run lo..hi, store it and return true.
+bool ByteSet::single_range(unsigned char &lo, unsigned char &hi) const {
+  int c = 0;
+
+  // find the start of the first run
+  while (c < 256 && !contains(c)) {
+    c++;
+  }
+  if (c == 256) {
+    return false;
+  }
+  lo = c;
+
+  // find the end of the first run
+  while (c < 256 && contains(c)) {
+    c++;
+  }
+  hi = c - 1;
+
+  // there must be nothing after the run
+  while (c < 256) {
+    if (contains(c)) {
+      return false;
+    }
+    c++;
+  }
+
+  return true;
+}
+
+// a hash of the members
+uint64_t ByteSet::hash() const {
+  uint64_t result = 0;
+  for (int i = 0; i < 4; i++) {
+    result = (result ^ _bits[i]) * 0x9E3779B97F4A7C15ull;
+  }
+  return result;
+}
+
+bool ByteSet::operator==(const ByteSet &other) const {
+  for (int i = 0; i < 4; i++) {
+    if (_bits[i] != other._bits[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ByteSet::operator!=(const ByteSet &other) const {
+  return !(*this == other);
+}
@@ -0,0 +1,55 @@
+// File: byte_set.h
+// Purpose: A set of bytes stored as a 256-bit bitmap.
+// Author: Robert Lowe
+#ifndef BYTE_SET_H
+#define BYTE_SET_H
+#include <cstdint>
+
+class ByteSet {
+public:
+  // construct an empty set
+  ByteSet();
+
+  // add a single byte to the set
+  void add(unsigned char c);
+
+  // add every byte in the range lo..hi to the set
+  void add_range(unsigned char lo, unsigned char hi);
+
+  // add every member of another set to this set
+  void merge(const ByteSet &other);
+
+  // add every byte to the set
+  void fill();
+
+  // replace the set with its complement
+  void invert();
+
+  // return true if c is a member of the set
+  bool contains(unsigned char c) const {
+    return (_bits[c >> 6] >> (c & 63)) & 1;
+  }
+
+  // return the number of members in the set
+  int count() const;
+
+  // return true if the set has no members
+  bool empty() const;
+
+  // return true if the set holds every byte
+  bool full() const;
+
+  // If the members form a single run lo..hi, store it and return true.
+  bool single_range(unsigned char &lo, unsigned char &hi) const;
+
+  // a hash of the members
+  uint64_t hash() const;
+
+  bool operator==(const ByteSet &other) const;
+  bool operator!=(const ByteSet &other) const;
+
+private:
+  uint64_t _bits[4];
+};
+
+#endif
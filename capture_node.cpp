@@ -0,0 +1,44 @@
+// File: capture_node.cpp
+// Purpose: A parenthesized group whose boundaries are reported by a match.
+// Author: Robert Lowe
+#include "capture_node.h"
+#include "nfa_compiler.h"
+
+// Construct capture group number index around the node.
+CaptureNode::CaptureNode(int index, RegexNode *node)
+    : _index(index), _node(node) {}
+
+CaptureNode::~CaptureNode() { RegexNode::unref(_node); }
+
+// Attempt to match the string at position pos. The tree does not record
+// groups, so this is just the node's match.
+bool CaptureNode::match(const std::string &str, size_t &pos) {
+  return _node->match(str, pos);
+}
+
+// Compile the group between two saves:
+//   save 2*index
+//   <node>
+//   save 2*index+1
+bool CaptureNode::compile(NfaCompiler &compiler) {
+  compiler.emit_save(2 * _index);
+  if (!compiler.compile_node(_node)) {
+    return false;
+  }
+  compiler.emit_save(2 * _index + 1);
+  return true;
+}
+
+// A capture begins like its node.
+bool CaptureNode::first_bytes(ByteSet &set) { return _node->first_bytes(set); }
+
+// retrieve the group number and the node which is captured
+int CaptureNode::index() const { return _index; }
+RegexNode *CaptureNode::node() const { return _node; }
+
+// give up the node without deleting it
+RegexNode *CaptureNode::release() {
+  RegexNode *result = _node;
+  _node = nullptr;
+  return result;
+}
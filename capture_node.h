@@ -0,0 +1,36 @@
+// File: capture_node.h
+// Purpose: A parenthesized group whose boundaries are reported by a match.
+// Author: Robert Lowe
+#ifndef CAPTURE_NODE_H
+#define CAPTURE_NODE_H
+#include "regex_node.h"
+
+class CaptureNode : public RegexNode {
+public:
+  // Construct capture group number index around the node. Groups are
+  // numbered from 1 in the order of their left parentheses.
+  CaptureNode(int index, RegexNode *node);
+  ~CaptureNode();
+
+  // attempt to match the string at position pos
+  virtual bool match(const std::string &str, size_t &pos);
+
+  // compile the node between instructions saving where it begins and ends
+  virtual bool compile(NfaCompiler &compiler);
+
+  // the bytes which can begin a match, and whether it may be empty
+  virtual bool first_bytes(ByteSet &set);
+
+  // retrieve the group number and the node which is captured
+  int index() const;
+  RegexNode *node() const;
+
+  // give up the node without deleting it, returning it
+  RegexNode *release();
+
+private:
+  int _index;
+  RegexNode *_node;
+};
+
+#endif
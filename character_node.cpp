@@ -3,6 +3,7 @@
 // Author: Robert Lowe  
 #include <string>
 #include "character_node.h"
+#include "byte_set.h"
 
 // construct a character node
 CharacterNode::CharacterNode(char _c)
@@ -18,4 +19,10 @@ bool CharacterNode::match(const std::string &str, size_t &pos) {
   }
 
   return false;
-}
\ No newline at end of file
+}
+
+// a character node matches the set holding only its character
+bool CharacterNode::byte_set(ByteSet &set) {
+  set.add(_c);
+  return true;
+}
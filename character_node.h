@@ -15,6 +15,9 @@ public:
   // Attempt to match the string beginning at the given position.
   virtual bool match(const std::string &str, size_t &pos);
 
+  // a character node matches the set holding only its character
+  virtual bool byte_set(ByteSet &set);
+
 private:
   char _c;
 };
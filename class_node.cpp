@@ -0,0 +1,83 @@
+// File: class_node.cpp
+// Purpose: A node which matches one character from a character class.
+// Author: Robert Lowe
+#include "class_node.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+const int ClassNode::MAX_RANGES;
+
+// construct a node matching any byte in set
+ClassNode::ClassNode(const ByteSet &set) : _set(set), _nranges(0) {
+  // break the set into runs for the vector loop
+  for (int c = 0; c < 256;) {
+    if (!_set.contains(c)) {
+      c++;
+      continue;
+    }
+    if (_nranges == MAX_RANGES) {
+      _nranges = -1;
+      break;
+    }
+    _lo[_nranges] = c;
+    while (c < 256 && _set.contains(c)) {
+      c++;
+    }
+    _hi[_nranges++] = c - 1;
+  }
+}
+
+// Attempt to match the string beginning at the given position.
+bool ClassNode::match(const std::string &str, size_t &pos) {
+  if (pos < str.length() && _set.contains(str[pos])) {
+    pos++;
+    return true;
+  }
+
+  return false;
+}
+
+// a class node matches its set
+bool ClassNode::byte_set(ByteSet &set) {
+  set.merge(_set);
+  return true;
+}
+
+// Return the number of bytes at the start of data which are in the class.
+size_t ClassNode::span(const char *data, size_t n) const {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  if (_nranges > 0) {
+    // A byte b is in lo..hi when the wrapping difference b - lo is at most
+    // hi - lo, compared unsigned.
+    __m128i lo[MAX_RANGES], width[MAX_RANGES];
+    for (int r = 0; r < _nranges; r++) {
+      lo[r] = _mm_set1_epi8(_lo[r]);
+      width[r] = _mm_set1_epi8(_hi[r] - _lo[r]);
+    }
+
+    for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+      __m128i in = _mm_setzero_si128();
+      for (int r = 0; r < _nranges; r++) {
+        __m128i d = _mm_sub_epi8(v, lo[r]);
+        in = _mm_or_si128(in, _mm_cmpeq_epi8(_mm_min_epu8(d, width[r]), d));
+      }
+
+      unsigned mask = _mm_movemask_epi8(in);
+      if (mask != 0xffff) {
+        return i + __builtin_ctz(~mask);
+      }
+    }
+  }
+#endif
+
+  while (i < n && _set.contains(data[i])) {
+    i++;
+  }
+
+  return i;
+}
@@ -0,0 +1,38 @@
+// File: class_node.h
+// Purpose: A node which matches one character from a character class. The
+//          class is a 256-bit bitmap, so each test is a single bit test.
+// Author: Robert Lowe
+#ifndef CLASS_NODE_H
+#define CLASS_NODE_H
+#include <string>
+#include "byte_set.h"
+#include "regex_node.h"
+
+class ClassNode : public RegexNode {
+public:
+  // construct a node matching any byte in set
+  ClassNode(const ByteSet &set);
+
+  // Attempt to match the string beginning at the given position.
+  virtual bool match(const std::string &str, size_t &pos);
+
+  // a class node matches its set
+  virtual bool byte_set(ByteSet &set);
+
+  // Return the number of bytes at the start of data..data+n which are in
+  // the class. Classes made of a few ranges are checked 16 bytes at a time.
+  size_t span(const char *data, size_t n) const;
+
+private:
+  // the most ranges the vector loop can check
+  static const int MAX_RANGES = 4;
+
+  ByteSet _set;
+
+  // the class as a list of ranges, if it has few enough
+  int _nranges;
+  unsigned char _lo[MAX_RANGES];
+  unsigned char _hi[MAX_RANGES];
+};
+
+#endif
@@ -0,0 +1,353 @@
+// File: dfa.cpp
+// Purpose: Run a compiled program as a fully determinized, minimized DFA.
+// Author: Robert Lowe
+#include "dfa.h"
+#include <algorithm>
+#include <map>
+#include <utility>
+
+const size_t Dfa::DEFAULT_STATE_LIMIT;
+const int Dfa::DEAD;
+
+//////////////////////////////////////////
+// Dfa Methods
+//////////////////////////////////////////
+
+// construct an empty dfa
+Dfa::Dfa()
+    : _stride(1), _start(DEAD), _program(nullptr), _state_limit(0),
+      _forward(nullptr), _reverse(nullptr), _nfa(nullptr) {}
+
+// Build the minimized dfa for the program by subset construction
+Dfa *Dfa::build(const Program *program, size_t state_limit) {
+  Dfa *dfa = build(program, StateBuilder::ANCHORED, state_limit);
+  if (dfa) {
+    dfa->_program = program;
+    dfa->_state_limit = state_limit;
+  }
+  return dfa;
+}
+
+// Build the minimized automaton of the given kind for the program
+Dfa *Dfa::build(const Program *program, StateBuilder::Kind kind,
+                size_t state_limit) {
+  Dfa *dfa = new Dfa();
+  StateBuilder builder(program, kind);
+  std::map<std::vector<int>, int> states;
+  std::vector<std::vector<int>> keys;
+  std::vector<int> key;
+
+  // the transitions are indexed by the program's byte classes
+  dfa->_stride = program->alphabet_size();
+  for (int c = 0; c < 256; c++) {
+    dfa->_symbol[c] = program->symbol(c);
+  }
+
+  // the dead state has no instructions
+  states[key] = DEAD;
+  keys.push_back(key);
+
+  // the start state
+  builder.start(key);
+  if (states.find(key) == states.end()) {
+    states[key] = keys.size();
+    keys.push_back(key);
+  }
+  dfa->_start = states[key];
+
+  // build the transitions of each state in turn, discovering new ones
+  for (size_t s = 0; s < keys.size(); s++) {
+    dfa->_accept.push_back(builder.accept(keys[s]));
+
+    for (int sym = 0; sym < dfa->_stride; sym++) {
+      builder.step(keys[s], program->representative(sym), key);
+
+      auto found = states.find(key);
+      if (found == states.end()) {
+        if (keys.size() >= state_limit) {
+          delete dfa;
+          return nullptr;
+        }
+        found = states.emplace(key, keys.size()).first;
+        keys.push_back(key);
+      }
+      dfa->_table.push_back(found->second);
+    }
+  }
+
+  dfa->minimize();
+  return dfa;
+}
+
+// Free the automata built for searching
+Dfa::~Dfa() {
+  delete _forward;
+  delete _reverse;
+  delete _nfa;
+}
+
+// Attempt an anchored match of the string beginning at pos
+bool Dfa::match(std::string_view str, size_t pos, size_t &end) {
+  int id;
+  return match(str, pos, end, id);
+}
+
+// Attempt an anchored match, also reporting the match id
+bool Dfa::match(std::string_view str, size_t pos, size_t &end, int &id) {
+  const int *table = _table.data();
+  bool matched = false;
+  int s = _start;
+
+  if (_accept[s] >= 0) {
+    matched = true;
+    end = pos;
+    id = _accept[s];
+  }
+
+  _examined = str.length() + 1;
+  for (size_t p = pos; p < str.length(); p++) {
+    s = table[s * _stride + _symbol[(unsigned char)str[p]]];
+    if (s == DEAD) {
+      _examined = p + 1;
+      break;
+    }
+    if (_accept[s] >= 0) {
+      matched = true;
+      end = p + 1;
+      id = _accept[s];
+    }
+  }
+
+  return matched;
+}
+
+// Search for the leftmost-longest match. A forward pass which starts a
+// match at every byte finds where the match ends, and a reverse pass from
+// there finds where it begins.
+bool Dfa::search(std::string_view str, size_t pos, size_t &start,
+                 size_t &end) {
+  // a pattern which matches the empty string matches right away
+  if (_accept[_start] >= 0) {
+    start = pos;
+    return match(str, pos, end);
+  }
+
+  // build the search automata, settling for the nfa if they are too big
+  if (!_forward && !_nfa) {
+    _forward = build(_program, StateBuilder::SEARCH, _state_limit);
+    _reverse = build(_program, StateBuilder::REVERSE, _state_limit);
+    if (!_forward || !_reverse) {
+      delete _forward;
+      delete _reverse;
+      _forward = _reverse = nullptr;
+      _nfa = new PikeVM(_program);
+    }
+  }
+  if (_nfa) {
+    return _nfa->search(str, pos, start, end);
+  }
+
+  if (!_forward->match(str, pos, end)) {
+    return false;
+  }
+  _reverse->match_back(str, pos, end, start);
+  return true;
+}
+
+// Run the reverse automaton backward from end, reporting the smallest start
+// no earlier than pos which it accepts
+bool Dfa::match_back(std::string_view str, size_t pos, size_t end,
+                     size_t &start) {
+  const int *table = _table.data();
+  bool matched = false;
+  int s = _start;
+
+  if (_accept[s] >= 0) {
+    matched = true;
+    start = end;
+  }
+
+  for (size_t p = end; p > pos; p--) {
+    s = table[s * _stride + _symbol[(unsigned char)str[p - 1]]];
+    if (s == DEAD) {
+      break;
+    }
+    if (_accept[s] >= 0) {
+      matched = true;
+      start = p - 1;
+    }
+  }
+
+  return matched;
+}
+
+// the number of states
+size_t Dfa::state_count() const { return _accept.size(); }
+
+// the size of the tables in bytes
+size_t Dfa::table_bytes() const {
+  return _table.size() * sizeof(int) + _accept.size() * sizeof(int) +
+         sizeof(_symbol);
+}
+
+// Merge equivalent states using Hopcroft's algorithm. The states start out
+// partitioned by the id they accept, and blocks are split until every state
+// in a block moves to the same block on every byte class.
+void Dfa::minimize() {
+  int n = _accept.size();
+
+  // the predecessors of each state on each byte class, indexed by
+  // pred_start[t * _stride + c] .. pred_start[t * _stride + c + 1]
+  std::vector<int> pred_start(n * _stride + 1, 0);
+  std::vector<int> preds(n * _stride);
+  for (int s = 0; s < n; s++) {
+    for (int c = 0; c < _stride; c++) {
+      pred_start[_table[s * _stride + c] * _stride + c + 1]++;
+    }
+  }
+  for (int i = 0; i < n * _stride; i++) {
+    pred_start[i + 1] += pred_start[i];
+  }
+  std::vector<int> fill(pred_start.begin(), pred_start.end() - 1);
+  for (int s = 0; s < n; s++) {
+    for (int c = 0; c < _stride; c++) {
+      preds[fill[_table[s * _stride + c] * _stride + c]++] = s;
+    }
+  }
+
+  // The partition keeps the members of each block contiguous in elems,
+  // with the marked members of a block at its front.
+  std::vector<int> elems(n), loc(n), block_of(n);
+  std::vector<int> first, last, marked;
+
+  // the initial blocks group states by the id they accept
+  std::map<int, int> by_accept;
+  for (int s = 0; s < n; s++) {
+    if (by_accept.find(_accept[s]) == by_accept.end()) {
+      int b = by_accept.size();
+      by_accept[_accept[s]] = b;
+    }
+  }
+  std::vector<int> counts(by_accept.size(), 0);
+  for (int s = 0; s < n; s++) {
+    block_of[s] = by_accept[_accept[s]];
+    counts[block_of[s]]++;
+  }
+  for (size_t b = 0, next = 0; b < counts.size(); b++) {
+    first.push_back(next);
+    last.push_back(next);
+    marked.push_back(0);
+    next += counts[b];
+  }
+  for (int s = 0; s < n; s++) {
+    int b = block_of[s];
+    loc[s] = last[b];
+    elems[last[b]++] = s;
+  }
+
+  // every block starts out as a splitter on every byte class
+  std::vector<std::pair<int, int>> work;
+  std::vector<bool> waiting;
+  for (size_t b = 0; b < first.size(); b++) {
+    for (int c = 0; c < _stride; c++) {
+      work.push_back(std::make_pair(b, c));
+      waiting.push_back(true);
+    }
+  }
+
+  std::vector<int> splitter, touched;
+  while (!work.empty()) {
+    int b = work.back().first;
+    int c = work.back().second;
+    work.pop_back();
+    waiting[b * _stride + c] = false;
+
+    // mark the states which move into block b on c
+    splitter.assign(elems.begin() + first[b], elems.begin() + last[b]);
+    touched.clear();
+    for (auto t : splitter) {
+      int begin = pred_start[t * _stride + c];
+      int end = pred_start[t * _stride + c + 1];
+      for (int i = begin; i < end; i++) {
+        int s = preds[i];
+        int y = block_of[s];
+        if (loc[s] < first[y] + marked[y]) {
+          continue;
+        }
+        if (marked[y] == 0) {
+          touched.push_back(y);
+        }
+
+        // swap s to the end of the marked region
+        int m = first[y] + marked[y]++;
+        int other = elems[m];
+        elems[m] = s;
+        elems[loc[s]] = other;
+        loc[other] = loc[s];
+        loc[s] = m;
+      }
+    }
+
+    // split every block which was only partly marked
+    for (auto y : touched) {
+      int split = first[y] + marked[y];
+      marked[y] = 0;
+      if (split == last[y]) {
+        continue;
+      }
+
+      // the marked states form the new block
+      int z = first.size();
+      first.push_back(first[y]);
+      last.push_back(split);
+      marked.push_back(0);
+      first[y] = split;
+      for (int i = first[z]; i < last[z]; i++) {
+        block_of[elems[i]] = z;
+      }
+
+      for (int a = 0; a < _stride; a++) {
+        waiting.push_back(false);
+      }
+      for (int a = 0; a < _stride; a++) {
+        // keep y waiting if it was, otherwise the smaller half suffices
+        int add = z;
+        if (!waiting[y * _stride + a] &&
+            last[y] - first[y] < last[z] - first[z]) {
+          add = y;
+        }
+        if (!waiting[add * _stride + a]) {
+          waiting[add * _stride + a] = true;
+          work.push_back(std::make_pair(add, a));
+        }
+      }
+    }
+  }
+
+  // number the blocks, keeping the dead state's block first
+  std::vector<int> number(first.size(), -1);
+  std::vector<int> rep;
+  number[block_of[DEAD]] = 0;
+  rep.push_back(DEAD);
+  for (int s = 0; s < n; s++) {
+    if (number[block_of[s]] < 0) {
+      number[block_of[s]] = rep.size();
+      rep.push_back(s);
+    }
+  }
+
+  // build the minimized tables from one representative of each block
+  std::vector<int> table(rep.size() * _stride);
+  std::vector<int> accept(rep.size());
+  for (size_t i = 0; i < rep.size(); i++) {
+    accept[i] = _accept[rep[i]];
+    for (int c = 0; c < _stride; c++) {
+      int t = _table[rep[i] * _stride + c];
+      table[i * _stride + c] = number[block_of[t]];
+    }
+  }
+
+  _start = number[block_of[_start]];
+  _table.swap(table);
+  _accept.swap(accept);
+}
@@ -0,0 +1,88 @@
+// File: dfa.h
+// Purpose: Run a compiled program as a fully determinized, minimized DFA.
+//          The whole automaton is built ahead of time into a dense
+//          transition table, so matching is one table lookup per byte.
+// Author: Robert Lowe
+#ifndef DFA_H
+#define DFA_H
+#include <vector>
+#include "matcher.h"
+#include "pike_vm.h"
+#include "program.h"
+#include "state_builder.h"
+
+class Dfa : public Matcher {
+public:
+  // the default limit on the number of states a dfa may have
+  static const size_t DEFAULT_STATE_LIMIT = 10000;
+
+  // Build the minimized dfa for the program, which must outlive the dfa.
+  // Returns nullptr if subset construction needs more than state_limit
+  // states.
+  static Dfa *build(const Program *program,
+                    size_t state_limit = DEFAULT_STATE_LIMIT);
+
+  // free the automata built for searching
+  virtual ~Dfa();
+
+  // Attempt an anchored match of the string beginning at pos, reporting the
+  // end of the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end);
+
+  // Attempt an anchored match, also reporting the smallest match id among
+  // the program's match instructions accepting the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end,
+                     int &id);
+
+  // Search for the leftmost-longest match in time linear in the input. The
+  // first search builds a forward automaton which starts a match at every
+  // byte and a reverse one, under the same state limit, falling back on
+  // the nfa if either is too big.
+  virtual bool search(std::string_view str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // the number of states and the size of the tables in bytes
+  size_t state_count() const;
+  size_t table_bytes() const;
+
+private:
+  // the state which matches nothing more
+  static const int DEAD = 0;
+
+  // the byte class of each byte, and the number of classes
+  unsigned char _symbol[256];
+  int _stride;
+
+  // the transitions, indexed by state * _stride + byte class
+  std::vector<int> _table;
+
+  // the match id each state accepts, or -1
+  std::vector<int> _accept;
+
+  int _start;
+
+  // the program, and the automata which find where a search's match ends
+  // and begins, or the nfa used instead when they are too big
+  const Program *_program;
+  size_t _state_limit;
+  Dfa *_forward;
+  Dfa *_reverse;
+  PikeVM *_nfa;
+
+  // construct an empty dfa
+  Dfa();
+
+  // build the minimized automaton of the given kind for the program
+  static Dfa *build(const Program *program, StateBuilder::Kind kind,
+                    size_t state_limit);
+
+  // Run the reverse automaton backward from end, reporting the smallest
+  // start no earlier than pos which it accepts.
+  bool match_back(std::string_view str, size_t pos, size_t end,
+                  size_t &start);
+
+  // merge equivalent states using Hopcroft's algorithm
+  void minimize();
+};
+
+#endif
@@ -0,0 +1,450 @@
+// File: flat_regex.cpp
+// Purpose: A regex tree flattened into one array of tagged nodes, with
+//          children referred to by index.
+// Author: Robert Lowe
+#include "flat_regex.h"
+#include <cstring>
+#include "regex.h"
+
+// the most memory the memo may take for one input
+const size_t FlatRegex::MEMO_BYTES = 64 << 20;
+
+// the most memory the memo keeps from one input to the next
+const size_t FlatRegex::MEMO_KEEP_BYTES = 1 << 20;
+
+// The failures recorded during one match or search, one bit for each inner
+// node at each position from base on. The words with bits set are listed,
+// so that clearing them costs no more than setting them did.
+struct FailureMemo {
+  std::vector<uint64_t> bits;
+  std::vector<size_t> dirty;
+  size_t base;
+  size_t rows; // 0 while the memo is off
+};
+
+static thread_local FailureMemo memo;
+
+// Flatten the tree rooted at root
+FlatRegex *FlatRegex::build(RegexNode *root) {
+  FlatRegex *result = new FlatRegex();
+
+  result->_root = result->add(root);
+  result->_shared.clear();
+  if (result->_root < 0) {
+    delete result;
+    return nullptr;
+  }
+  result->plan_memo();
+
+  return result;
+}
+
+// Attempt to match the string beginning at the given position.
+bool FlatRegex::match(const std::string &str, size_t &pos) {
+  return match(std::string_view(str), pos);
+}
+
+// attempt to match any buffer beginning at the given position
+bool FlatRegex::match(std::string_view str, size_t &pos) const {
+  bool memoized = begin_memo(pos, str.length());
+  bool result = run(_root, str.data(), str.length(), pos);
+  if (memoized) {
+    end_memo();
+  }
+  return result;
+}
+
+// Search for the leftmost match beginning at or after pos. The failures
+// found at one starting position still hold at the next, so the memo is
+// kept for the whole search.
+bool FlatRegex::search(const std::string &str, size_t pos, size_t &start,
+                       size_t &end) {
+  bool memoized = begin_memo(pos, str.length());
+  bool found = false;
+
+  for (; !found && pos <= str.length(); pos++) {
+    size_t p = pos;
+    if (run(_root, str.data(), str.length(), p)) {
+      start = pos;
+      end = p;
+      found = true;
+    }
+  }
+
+  if (memoized) {
+    end_memo();
+  }
+  return found;
+}
+
+// true if the regex memoizes the nodes which fail at each position
+bool FlatRegex::memoized() const { return _memo_rows > 0; }
+
+// the memory the memo holds on this thread
+size_t FlatRegex::memo_bytes() {
+  return memo.bits.capacity() * sizeof(uint64_t) +
+         memo.dirty.capacity() * sizeof(size_t);
+}
+
+// the number of nodes
+size_t FlatRegex::size() const { return _nodes.size(); }
+
+// construct an empty flat regex
+FlatRegex::FlatRegex() : _root(-1), _memo_rows(0) {}
+
+// Switch on the memo if some repeated node holds a quantifier. Children
+// are added before their parents, so one pass in order sees each child
+// first.
+void FlatRegex::plan_memo() {
+  std::vector<bool> quantified(_nodes.size());
+  bool nested = false;
+
+  for (size_t n = 0; n < _nodes.size(); n++) {
+    const Node &node = _nodes[n];
+    bool repeated = node.kind == STAR || node.kind == PLUS;
+
+    if (node.kind == GROUP || node.kind == OR) {
+      for (int i = 0; i < node.b; i++) {
+        quantified[n] = quantified[n] || quantified[_children[node.a + i]];
+      }
+    } else if (node.kind > GROUP) {
+      quantified[n] = repeated || node.kind == OPTIONAL || quantified[node.a];
+      nested = nested || (repeated && quantified[node.a]);
+    }
+  }
+
+  // each inner node gets a row
+  _memo_rows = 0;
+  for (auto &node : _nodes) {
+    node.memo = nested && node.kind >= GROUP ? _memo_rows++ : -1;
+  }
+}
+
+// Prepare the memo for the positions from pos to len
+bool FlatRegex::begin_memo(size_t pos, size_t len) const {
+  memo.rows = 0;
+  if (_memo_rows == 0 || pos > len) {
+    return false;
+  }
+
+  size_t words = ((len - pos + 1) * _memo_rows + 63) / 64;
+  if (words > MEMO_BYTES / 8) {
+    return false;
+  }
+  if (memo.bits.size() < words) {
+    memo.bits.resize(words);
+  }
+  memo.base = pos;
+  memo.rows = _memo_rows;
+  return true;
+}
+
+// Clear the failures recorded since begin_memo. A memo grown past
+// MEMO_KEEP_BYTES is released instead, so that one long input does not
+// leave the thread holding it.
+void FlatRegex::end_memo() const {
+  if (memo.bits.size() * sizeof(uint64_t) > MEMO_KEEP_BYTES) {
+    std::vector<uint64_t>().swap(memo.bits);
+    std::vector<size_t>().swap(memo.dirty);
+  } else {
+    for (auto word : memo.dirty) {
+      memo.bits[word] = 0;
+    }
+    memo.dirty.clear();
+  }
+  memo.rows = 0;
+}
+
+// Add the node for a tree node, once for each shared one
+int FlatRegex::add(RegexNode *node) {
+  if (!node) {
+    return -1;
+  }
+  if (node->references() == 1) {
+    return add_new(node);
+  }
+
+  auto found = _shared.find(node);
+  if (found != _shared.end()) {
+    return found->second;
+  }
+  int index = add_new(node);
+  _shared[node] = index;
+  return index;
+}
+
+// Add the node for a tree node. Any node of a single byte becomes one leaf,
+// and the rest are recognized by their classes.
+int FlatRegex::add_new(RegexNode *node) {
+  ByteSet set;
+  Node flat;
+  RegexNode *child = nullptr;
+
+  if (node->byte_set(set)) {
+    return add_set(set);
+  }
+
+  // the flat form has no groups to report, so a capture is its node
+  if (CaptureNode *capture = dynamic_cast<CaptureNode *>(node)) {
+    return add(capture->node());
+  }
+
+  if (LiteralNode *literal = dynamic_cast<LiteralNode *>(node)) {
+    flat.kind = LITERAL;
+    flat.lo = flat.hi = 0;
+    flat.a = _text.size();
+    flat.b = literal->text().size();
+    _text.append(literal->text());
+    _nodes.push_back(flat);
+    return _nodes.size() - 1;
+  } else if (dynamic_cast<GroupNode *>(node)) {
+    flat.kind = GROUP;
+  } else if (dynamic_cast<OrNode *>(node)) {
+    flat.kind = OR;
+  } else if (ZeroNode *zero = dynamic_cast<ZeroNode *>(node)) {
+    flat.kind = STAR;
+    child = zero->node();
+  } else if (OneNode *one = dynamic_cast<OneNode *>(node)) {
+    flat.kind = PLUS;
+    child = one->node();
+  } else if (OptionalNode *opt = dynamic_cast<OptionalNode *>(node)) {
+    flat.kind = OPTIONAL;
+    child = opt->node();
+  } else if (InverseNode *inv = dynamic_cast<InverseNode *>(node)) {
+    flat.kind = INVERSE;
+    child = inv->node();
+  } else {
+    return -1;
+  }
+  flat.lo = flat.hi = 0;
+
+  if (flat.kind == GROUP || flat.kind == OR) {
+    // add the children first, then list them side by side
+    const std::pmr::vector<RegexNode *> &nodes =
+        flat.kind == GROUP ? static_cast<GroupNode *>(node)->nodes()
+                           : static_cast<OrNode *>(node)->nodes();
+    std::vector<int> indices;
+    for (auto n : nodes) {
+      int index = add(n);
+      if (index < 0) {
+        return -1;
+      }
+      indices.push_back(index);
+    }
+    flat.a = _children.size();
+    flat.b = indices.size();
+    _children.insert(_children.end(), indices.begin(), indices.end());
+  } else {
+    flat.a = add(child);
+    flat.b = 0;
+    if (flat.a < 0) {
+      return -1;
+    }
+  }
+
+  _nodes.push_back(flat);
+  return _nodes.size() - 1;
+}
+
+// add a node matching one byte from set, as the cheapest kind of leaf
+int FlatRegex::add_set(const ByteSet &set) {
+  Node flat;
+  unsigned char lo, hi;
+
+  flat.a = flat.b = 0;
+  flat.lo = flat.hi = 0;
+  if (set.full()) {
+    flat.kind = ANY;
+  } else if (set.single_range(lo, hi)) {
+    flat.kind = lo == hi ? CHAR : RANGE;
+    flat.lo = lo;
+    flat.hi = hi;
+  } else {
+    flat.kind = CLASS;
+    flat.a = _sets.size();
+    _sets.push_back(set);
+  }
+
+  _nodes.push_back(flat);
+  return _nodes.size() - 1;
+}
+
+// return true if the one byte node consumes the byte c
+bool FlatRegex::test(const Node &node, unsigned char c) const {
+  switch (node.kind) {
+  case CHAR:
+    return c == node.lo;
+  case RANGE:
+    return c >= node.lo && c <= node.hi;
+  case CLASS:
+    return _sets[node.a].contains(c);
+  case ANY:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// return true if the node in the given row of the memo failed at pos
+static bool failed(int row, size_t pos) {
+  size_t bit = (pos - memo.base) * memo.rows + row;
+  return (memo.bits[bit >> 6] >> (bit & 63)) & 1;
+}
+
+// record that the node in the given row of the memo failed at pos
+static void fail(int row, size_t pos) {
+  size_t bit = (pos - memo.base) * memo.rows + row;
+  uint64_t &word = memo.bits[bit >> 6];
+  if (!word) {
+    memo.dirty.push_back(bit >> 6);
+  }
+  word |= uint64_t(1) << (bit & 63);
+}
+
+// Match a leaf at pos, moving pos past the match only if it succeeds
+bool FlatRegex::leaf(const Node &node, const char *s, size_t len,
+                     size_t &pos) const {
+  if (node.kind == LITERAL) {
+    if (pos > len || len - pos < (size_t)node.b ||
+        std::memcmp(s + pos, _text.data() + node.a, node.b) != 0) {
+      return false;
+    }
+    pos += node.b;
+    return true;
+  }
+
+  if (pos < len && test(node, s[pos])) {
+    pos++;
+    return true;
+  }
+  return false;
+}
+
+// Match node n at pos, with the semantics of the tree node it came from:
+// every choice is greedy and is never revisited. Repetitions stop when the
+// repeated node matches without consuming anything, where the tree would
+// loop forever.
+//
+// Rather than recursing, each inner node being matched has a frame on a
+// work stack. The frame on top either starts its next child or, once the
+// child is done, acts on ok, the child's result. Leaves are matched on the
+// spot. The stack belongs to the thread and is kept from match to match.
+// With the memo on, a node which failed at a position before fails there
+// again at once.
+bool FlatRegex::run(int n, const char *s, size_t len, size_t &pos) const {
+  static thread_local std::vector<Frame> stack;
+  size_t p = pos;
+  bool ok = false;
+
+  if (_nodes[n].kind <= LITERAL) {
+    return leaf(_nodes[n], s, len, pos);
+  }
+  if (memo.rows && failed(_nodes[n].memo, p)) {
+    return false;
+  }
+
+  stack.clear();
+  stack.push_back(Frame{n, 0, p, p});
+  while (!stack.empty()) {
+    Frame &frame = stack.back();
+    const Node &node = _nodes[frame.node];
+    int child = -1;
+    bool done = false;
+
+    switch (node.kind) {
+    case GROUP:
+      if (frame.step > 0 && !ok) {
+        p = frame.start;
+        done = true;
+      } else if (frame.step == node.b) {
+        ok = done = true;
+      } else {
+        child = _children[node.a + frame.step];
+      }
+      break;
+
+    case OR:
+      if (frame.step > 0 && ok) {
+        done = true;
+      } else if (frame.step == node.b) {
+        p = frame.start;
+        ok = false;
+        done = true;
+      } else {
+        p = frame.start;
+        child = _children[node.a + frame.step];
+      }
+      break;
+
+    case STAR:
+    case PLUS:
+      if (frame.step == 0 && _nodes[node.a].kind <= ANY) {
+        // the leaf test is inlined into the loop
+        const Node &repeat = _nodes[node.a];
+        while (p < len && test(repeat, s[p])) {
+          p++;
+        }
+        frame.mark = p;
+      } else if (frame.step == 0 || (ok && p > frame.mark)) {
+        // go again for as long as there is progress
+        frame.mark = p;
+        child = node.a;
+        break;
+      }
+      // a plus fails only if its first repetition does, which may match
+      // without consuming anything
+      p = frame.mark;
+      ok = node.kind == STAR || p > frame.start || (frame.step == 1 && ok);
+      done = true;
+      break;
+
+    case OPTIONAL:
+      if (frame.step == 0) {
+        child = node.a;
+      } else {
+        if (!ok) {
+          p = frame.start;
+        }
+        ok = done = true;
+      }
+      break;
+
+    case INVERSE:
+      if (frame.step == 0 && p < len) {
+        child = node.a;
+      } else {
+        ok = frame.step > 0 && !ok;
+        p = ok ? frame.start + 1 : frame.start;
+        done = true;
+      }
+      break;
+
+    default:
+      ok = false;
+      done = true;
+      break;
+    }
+
+    if (done) {
+      if (!ok && memo.rows) {
+        fail(node.memo, frame.start);
+      }
+      stack.pop_back();
+    } else if (_nodes[child].kind <= LITERAL) {
+      frame.step++;
+      ok = leaf(_nodes[child], s, len, p);
+    } else if (memo.rows && failed(_nodes[child].memo, p)) {
+      // this was tried before
+      frame.step++;
+      ok = false;
+    } else {
+      frame.step++;
+      stack.push_back(Frame{child, 0, p, p});
+    }
+  }
+
+  if (ok) {
+    pos = p;
+  }
+  return ok;
+}
@@ -0,0 +1,129 @@
+// File: flat_regex.h
+// Purpose: A regex tree flattened into one array of tagged nodes, with
+//          children referred to by index. A switch over the node kinds
+//          and a work stack replace the recursive virtual calls of the
+//          tree, and match exactly as the tree would.
+// Author: Robert Lowe
+#ifndef FLAT_REGEX_H
+#define FLAT_REGEX_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "byte_set.h"
+#include "regex_node.h"
+
+class FlatRegex : public RegexNode {
+public:
+  // Flatten the tree rooted at root, which the caller still owns. Returns
+  // nullptr if the tree holds a node which cannot be flattened.
+  static FlatRegex *build(RegexNode *root);
+
+  // Attempt to match the string beginning at the given position.
+  virtual bool match(const std::string &str, size_t &pos);
+
+  // attempt to match any buffer beginning at the given position
+  bool match(std::string_view str, size_t &pos) const;
+
+  // search for the leftmost match beginning at or after pos
+  virtual bool search(const std::string &str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // True if the regex memoizes the nodes which fail at each position, so
+  // that no node is tried twice at one position in a match or search.
+  // This is switched on for patterns with a quantifier inside a repeated
+  // node, where the same attempts are otherwise made over and over.
+  bool memoized() const;
+
+  // the most memory the memo may take for one input; a longer input is
+  // matched without it
+  static const size_t MEMO_BYTES;
+
+  // the most memory the memo keeps on a thread from one input to the next;
+  // a memo grown larger for a long input is released once it is done
+  static const size_t MEMO_KEEP_BYTES;
+
+  // the memory the memo holds on this thread
+  static size_t memo_bytes();
+
+  // the number of nodes
+  size_t size() const;
+
+private:
+  enum Kind : uint8_t {
+    CHAR,     // the byte lo
+    RANGE,    // a byte in lo..hi
+    CLASS,    // a byte in the set at index a
+    ANY,      // any byte
+    LITERAL,  // the b bytes of the text beginning at index a
+    GROUP,    // each of the b children listed from a, in turn
+    OR,       // the first of the b children listed from a which matches
+    STAR,     // the node at index a, as often as possible
+    PLUS,     // the node at index a, at least once
+    OPTIONAL, // the node at index a, if it matches
+    INVERSE   // one byte, where the node at index a does not match
+  };
+
+  struct Node {
+    Kind kind;
+    unsigned char lo;
+    unsigned char hi;
+    int a;
+    int b;
+    int memo; // the row of an inner node in the memo, or -1
+  };
+
+  // A node being matched: the number of its children started so far, the
+  // position where it began, and the position after its last repetition.
+  struct Frame {
+    int node;
+    int step;
+    size_t start;
+    size_t mark;
+  };
+
+  std::vector<Node> _nodes;
+  std::vector<int> _children;
+  std::vector<ByteSet> _sets;
+  std::string _text;
+  int _root;
+
+  // the number of rows in the memo, one for each inner node, or 0
+  int _memo_rows;
+
+  // the index of each shared tree node added so far
+  std::unordered_map<RegexNode *, int> _shared;
+
+  // construct an empty flat regex
+  FlatRegex();
+
+  // Add the node for a tree node, returning its index or -1. A tree node
+  // shared by several parents is added once.
+  int add(RegexNode *node);
+
+  // add the node for a tree node which has not been added before
+  int add_new(RegexNode *node);
+
+  // add a node matching one byte from set
+  int add_set(const ByteSet &set);
+
+  // match node n at pos, moving pos past the match only if it succeeds
+  bool run(int n, const char *s, size_t len, size_t &pos) const;
+
+  // switch on the memo if the pattern has nested quantifiers
+  void plan_memo();
+
+  // Prepare the memo for the positions from pos to len, returning false if
+  // it is off. end_memo clears the failures recorded since.
+  bool begin_memo(size_t pos, size_t len) const;
+  void end_memo() const;
+
+  // match a leaf at pos, moving pos past the match only if it succeeds
+  bool leaf(const Node &node, const char *s, size_t len, size_t &pos) const;
+
+  // return true if node n consumes the byte c, for nodes of one byte
+  bool test(const Node &node, unsigned char c) const;
+};
+
+#endif
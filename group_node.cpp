@@ -4,11 +4,17 @@
 #include <string>
 #include <vector>
 #include "group_node.h"
+#include "byte_set.h"
+#include "nfa_compiler.h"
+#include "node_arena.h"
 
-// Delete all the nodes in the group
+// construct an empty group, stored in the node arena in scope if any
+GroupNode::GroupNode() : _nodes(NodeArena::resource()) {}
+
+// Drop the references to the nodes in the group
 GroupNode::~GroupNode() {
   for (auto node : _nodes) {
-    delete node;
+    RegexNode::unref(node);
   }
 }
 
@@ -32,3 +38,41 @@ bool GroupNode::match(const std::string &str, size_t &pos) {
 void GroupNode::add_node(RegexNode *node) {
   this->_nodes.push_back(node);
 }
+
+// retrieve the nodes in the group
+const std::pmr::vector<RegexNode *> &GroupNode::nodes() const { return _nodes; }
+
+// give up the nodes without deleting them
+void GroupNode::release_nodes() { _nodes.clear(); }
+
+// A group of one single byte node matches that node's set
+bool GroupNode::byte_set(ByteSet &set) {
+  return _nodes.size() == 1 && _nodes[0] && _nodes[0]->byte_set(set);
+}
+
+// A group begins with its first node, and with each node after a run of
+// nullable ones.
+bool GroupNode::first_bytes(ByteSet &set) {
+  for (auto node : _nodes) {
+    if (!node) {
+      set.fill();
+      return true;
+    }
+    if (!node->first_bytes(set)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Compile the nodes of the group in sequence
+bool GroupNode::compile(NfaCompiler &compiler) {
+  for (auto node : _nodes) {
+    if (!compiler.compile_node(node)) {
+      return false;
+    }
+  }
+
+  return true;
+}
@@ -4,11 +4,15 @@
 #ifndef GROUP_NODE_H
 #define GROUP_NODE_H
 #include <string>
+#include <memory_resource>
 #include <vector>
 #include "regex_node.h"
 
 class GroupNode : public RegexNode {
 public:
+  // construct an empty group, stored in the node arena in scope if any
+  GroupNode();
+
   //delete all the nodes in the group
   virtual ~GroupNode();
 
@@ -18,8 +22,23 @@ public:
   // Add a node to the group
   virtual void add_node(RegexNode *node);
 
+  // retrieve the nodes in the group
+  const std::pmr::vector<RegexNode *> &nodes() const;
+
+  // give up the nodes without deleting them, leaving no nodes
+  void release_nodes();
+
+  // a group of one single byte node matches that node's set
+  virtual bool byte_set(ByteSet &set);
+
+  // the bytes which can begin a match, and whether it may be empty
+  virtual bool first_bytes(ByteSet &set);
+
+  // compile the nodes of the group in sequence
+  virtual bool compile(NfaCompiler &compiler);
+
 private:
-  std::vector<RegexNode *> _nodes;
+  std::pmr::vector<RegexNode *> _nodes;
 };
 
 #endif 
\ No newline at end of file
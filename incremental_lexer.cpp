@@ -0,0 +1,191 @@
+// File: incremental_lexer.cpp
+// Purpose: Keep the tokens of a text up to date as the text is edited.
+//          After each edit, only the tokens which could have changed are
+//          lexed again, and the rest move with the gap of a gap buffer.
+// Author: Robert Lowe
+#include "incremental_lexer.h"
+#include <algorithm>
+
+// Construct an incremental lexer which lexes with the given lexer
+IncrementalLexer::IncrementalLexer(Lexer &lexer)
+    : _lexer(lexer), _gap(0), _gap_end(0), _changed_begin(0),
+      _changed_end(0) {}
+
+// replace the text and lex all of it
+void IncrementalLexer::input(const std::string &text) {
+  _text = text;
+  _tok.clear();
+  _pos.clear();
+  _len.clear();
+  _reach.clear();
+  _gap = 0;
+  _gap_end = 0;
+  _changed_begin = 0;
+  relex(0);
+}
+
+// Replace removed bytes at offset with inserted, and bring the tokens up to
+// date
+void IncrementalLexer::edit(size_t offset, size_t removed,
+                            const std::string &inserted) {
+  offset = std::min(offset, _text.length());
+  removed = std::min(removed, _text.length() - offset);
+
+  // The first token to change is the first which examined the text from
+  // offset on. The extents never decrease, so it can be found by
+  // bisection.
+  size_t lo = 0, hi = size();
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (reach(mid) > offset) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  size_t first = lo;
+  size_t start = 0;
+  if (first < size()) {
+    start = pos(first);
+  } else if (first > 0) {
+    // no token examined the edit, so lexing resumes after the last one
+    start = pos(first - 1) + len(first - 1);
+  }
+
+  // old tokens which begin after the removed bytes are unchanged, apart
+  // from their position
+  hi = size();
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (pos(mid) < offset + removed) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  size_t resume = lo;
+
+  // put the gap where the edit is, dropping the tokens which must change
+  move_gap(first);
+  _gap_end += resume - first;
+
+  _text.replace(offset, removed, inserted);
+  _changed_begin = first;
+  relex(start);
+}
+
+// the text being lexed
+const std::string &IncrementalLexer::text() const { return _text; }
+
+// the tokens of the text
+size_t IncrementalLexer::size() const {
+  return _tok.size() - (_gap_end - _gap);
+}
+int IncrementalLexer::tok(size_t i) const { return _tok[index(i)]; }
+size_t IncrementalLexer::len(size_t i) const { return _len[index(i)]; }
+size_t IncrementalLexer::pos(size_t i) const {
+  return i < _gap ? _pos[i] : _text.length() - _pos[index(i)];
+}
+
+// the tokens lexed again by the last edit
+size_t IncrementalLexer::changed_begin() const { return _changed_begin; }
+size_t IncrementalLexer::changed_end() const { return _changed_end; }
+
+// the extent examined by token i and the tokens before it
+size_t IncrementalLexer::reach(size_t i) const {
+  return i < _gap ? _reach[i] : _text.length() - _reach[index(i)];
+}
+
+// Move the gap to just before token i, changing how the positions of the
+// tokens it passes are counted
+void IncrementalLexer::move_gap(size_t i) {
+  size_t length = _text.length();
+  while (_gap > i) {
+    _gap--;
+    _gap_end--;
+    _tok[_gap_end] = _tok[_gap];
+    _len[_gap_end] = _len[_gap];
+    _pos[_gap_end] = length - _pos[_gap];
+    _reach[_gap_end] = length - _reach[_gap];
+  }
+  while (_gap < i) {
+    _tok[_gap] = _tok[_gap_end];
+    _len[_gap] = _len[_gap_end];
+    _pos[_gap] = length - _pos[_gap_end];
+    _reach[_gap] = length - _reach[_gap_end];
+    _gap++;
+    _gap_end++;
+  }
+}
+
+// Append a token before the gap, growing the buffer if the gap is full
+void IncrementalLexer::push(int tok, size_t pos, size_t len, size_t reach) {
+  if (_gap == _gap_end) {
+    // double the buffer, moving the tokens after the gap to its end
+    size_t after = _tok.size() - _gap_end;
+    size_t capacity = std::max<size_t>(16, 2 * _tok.size());
+    _tok.resize(capacity);
+    _pos.resize(capacity);
+    _len.resize(capacity);
+    _reach.resize(capacity);
+    std::copy_backward(_tok.begin() + _gap_end, _tok.begin() + _gap_end + after,
+                       _tok.end());
+    std::copy_backward(_pos.begin() + _gap_end, _pos.begin() + _gap_end + after,
+                       _pos.end());
+    std::copy_backward(_len.begin() + _gap_end, _len.begin() + _gap_end + after,
+                       _len.end());
+    std::copy_backward(_reach.begin() + _gap_end,
+                       _reach.begin() + _gap_end + after, _reach.end());
+    _gap_end = capacity - after;
+  }
+
+  _tok[_gap] = tok;
+  _pos[_gap] = pos;
+  _len[_gap] = len;
+  _reach[_gap] = reach;
+  _gap++;
+}
+
+// Lex from start until the new tokens resynchronize with the old ones
+void IncrementalLexer::relex(size_t start) {
+  size_t length = _text.length();
+  size_t reached = _gap > 0 ? _reach[_gap - 1] : 0;
+
+  // lex the rest of the text, stopping at the first old token boundary.
+  // Tree patterns can only lex a copy of it.
+  std::string_view rest = std::string_view(_text).substr(start);
+  if (!_lexer.borrow(rest)) {
+    _lexer.input(std::string(rest));
+  }
+  for (;;) {
+    Lexer::TokenView t = _lexer.next_view();
+    if (t.tok == Lexer::END_OF_INPUT) {
+      _gap_end = _tok.size();
+      break;
+    }
+
+    size_t end = start + t.pos + t.lexeme.length();
+    reached = std::max(reached, start + _lexer.lookahead());
+    push(t.tok, start + t.pos, t.lexeme.length(), reached);
+
+    // drop the old tokens which the new one has run over
+    while (_gap_end < _tok.size() && length - _pos[_gap_end] < end) {
+      _gap_end++;
+    }
+    if (_gap_end < _tok.size() && length - _pos[_gap_end] == end) {
+      break;
+    }
+  }
+  _changed_end = _gap;
+
+  // Raise the extents of the old tokens kept to those of the new ones.
+  // Once an old extent is at least as great, the rest already are. An old
+  // extent may stay greater than it needs to be, which only means a later
+  // edit lexes a little more.
+  for (size_t i = _gap_end; i < _tok.size(); i++) {
+    if (length - _reach[i] >= reached) {
+      break;
+    }
+    _reach[i] = length - reached;
+  }
+}
@@ -0,0 +1,87 @@
+// File: incremental_lexer.h
+// Purpose: Keep the tokens of a text up to date as the text is edited.
+//          After each edit, only the tokens which could have changed are
+//          lexed again. The tokens are kept in a gap buffer whose gap
+//          follows the edits, so the tokens after an edit move with it
+//          without being touched.
+// Author: Robert Lowe
+#ifndef INCREMENTAL_LEXER_H
+#define INCREMENTAL_LEXER_H
+#include <string>
+#include <vector>
+#include "lexer.h"
+
+class IncrementalLexer {
+public:
+  // Construct an incremental lexer which lexes with the given lexer. The
+  // lexer's input is replaced each time text is lexed.
+  IncrementalLexer(Lexer &lexer);
+
+  // replace the text and lex all of it
+  void input(const std::string &text);
+
+  // Replace removed bytes at offset with inserted, and bring the tokens up
+  // to date. Lexing restarts at the first token which examined the edited
+  // part of the text, and stops once a new token ends where an old token
+  // beyond the edit begins. The old tokens from there on are kept. Apart
+  // from the text itself, an edit costs the tokens lexed again plus the
+  // tokens between it and the previous edit. A lexer with patterns which
+  // cannot be compiled also copies the text from the restart on.
+  void edit(size_t offset, size_t removed, const std::string &inserted);
+
+  // the text being lexed
+  const std::string &text() const;
+
+  // The tokens of the text, which never include the end of input token.
+  // Token i has the numeric token tok(i) and the lexeme pos(i)..pos(i) +
+  // len(i).
+  size_t size() const;
+  int tok(size_t i) const;
+  size_t pos(size_t i) const;
+  size_t len(size_t i) const;
+
+  // the tokens lexed again by the last edit, from changed_begin() up to but
+  // not including changed_end()
+  size_t changed_begin() const;
+  size_t changed_end() const;
+
+private:
+  Lexer &_lexer;
+  std::string _text;
+
+  // The tokens, with the greatest extent examined by each one and the
+  // tokens before it. Token i is at index i before the gap _gap.._gap_end,
+  // and past it otherwise. The positions and extents of the tokens after
+  // the gap count back from the end of the text, so they stay right when
+  // the text before them changes length. An extent may be one past the
+  // end of the text, which wraps around.
+  std::vector<int> _tok;
+  std::vector<size_t> _pos;
+  std::vector<size_t> _len;
+  std::vector<size_t> _reach;
+  size_t _gap;
+  size_t _gap_end;
+
+  size_t _changed_begin;
+  size_t _changed_end;
+
+  // the index in the buffer of token i
+  size_t index(size_t i) const { return i < _gap ? i : i + _gap_end - _gap; }
+
+  // the extent examined by token i and the tokens before it
+  size_t reach(size_t i) const;
+
+  // move the gap to just before token i
+  void move_gap(size_t i);
+
+  // append a token before the gap, growing the buffer if the gap is full
+  void push(int tok, size_t pos, size_t len, size_t reach);
+
+  // Lex from start, which is where the token just after the gap begins,
+  // until a new token ends where an old token after the gap begins. The
+  // new tokens go before the gap, and the old ones they run over are
+  // dropped.
+  void relex(size_t start);
+};
+
+#endif
@@ -2,13 +2,14 @@
 // Purpose: Definition of the inverse node class.
 // Author: Robert Lowe
 #include "inverse_node.h"
+#include "byte_set.h"
 
 // Constructor
 InverseNode::InverseNode(RegexNode *node) : _node(node) {}
 
 // Destructor
 InverseNode::~InverseNode() {
-  delete _node;
+  RegexNode::unref(_node);
 }
 
 // Attempt to match the string at position pos
@@ -27,3 +28,19 @@ bool InverseNode::match(const std::string &str, size_t &pos) {
   pos = originalPos;
   return false;
 }
+
+// The inverse of a node with a byte set is the complement of that set.
+bool InverseNode::byte_set(ByteSet &set) {
+  ByteSet inner;
+
+  if (!_node || !_node->byte_set(inner)) {
+    return false;
+  }
+
+  inner.invert();
+  set.merge(inner);
+  return true;
+}
+
+// retrieve the node to invert
+RegexNode *InverseNode::node() const { return _node; }
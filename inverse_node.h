@@ -13,6 +13,12 @@ public:
   // attempt to match the string at position pos
   virtual bool match(const std::string& str, size_t &pos);
 
+  // the complement of the inner node's byte set
+  virtual bool byte_set(ByteSet &set);
+
+  // retrieve the node to invert
+  RegexNode *node() const;
+
 private:
   RegexNode* _node;
 };
@@ -0,0 +1,290 @@
+// File: lazy_dfa.cpp
+// Purpose: Run a compiled program as a DFA whose states are built on demand
+//          while scanning.
+// Author: Robert Lowe
+#include "lazy_dfa.h"
+#include <algorithm>
+
+const size_t LazyDfa::DEFAULT_CACHE_BYTES;
+const int LazyDfa::UNKNOWN;
+const int LazyDfa::DEAD;
+
+// A cache which is cleared after fewer than MIN_BYTES_PER_STATE bytes were
+// scanned for each state it built is thrashing. After MAX_CLEARS such clears
+// in one match, the dfa gives up on the cache.
+static const size_t MAX_CLEARS = 3;
+static const size_t MIN_BYTES_PER_STATE = 10;
+
+// the approximate memory used by a state with a key of n instructions and
+// a row of stride transitions
+static size_t state_bytes(size_t n, size_t stride) {
+  return stride * sizeof(int) + 2 * n * sizeof(int) + 96;
+}
+
+// Construct a dfa to run the program
+LazyDfa::LazyDfa(const Program *program, size_t cache_bytes)
+    : LazyDfa(program, StateBuilder::ANCHORED, cache_bytes) {}
+
+// Construct an automaton of the given kind for the program
+LazyDfa::LazyDfa(const Program *program, StateBuilder::Kind kind,
+                 size_t cache_bytes)
+    : _program(program), _cache_bytes(cache_bytes),
+      _stride(program->alphabet_size()), _scanned(0), _built(0),
+      _thrashing(0), _builder(program, kind), _nfa(program),
+      _forward(nullptr), _reverse(nullptr) {
+  reset_stats();
+  clear();
+  _stats.clears = 0;
+}
+
+// Free the automata built for searching
+LazyDfa::~LazyDfa() {
+  delete _forward;
+  delete _reverse;
+}
+
+// Attempt an anchored match of the string beginning at pos
+bool LazyDfa::match(std::string_view str, size_t pos, size_t &end) {
+  int id;
+  return match(str, pos, end, id);
+}
+
+// Attempt an anchored match, also reporting the match id
+bool LazyDfa::match(std::string_view str, size_t pos, size_t &end, int &id) {
+  int matched = scan(str, pos, end, id);
+  if (matched < 0) {
+    _stats.fallbacks++;
+    return nfa_match(str, pos, end, id);
+  }
+  return matched;
+}
+
+// Search for the leftmost-longest match. A forward pass which starts a
+// match at every byte finds where the match ends, and a reverse pass from
+// there finds where it begins.
+bool LazyDfa::search(std::string_view str, size_t pos, size_t &start,
+                     size_t &end) {
+  // a pattern which matches the empty string matches right away
+  if (_start >= 0 && _accept[_start] >= 0) {
+    start = pos;
+    return match(str, pos, end);
+  }
+
+  if (!_forward) {
+    _forward = new LazyDfa(_program, StateBuilder::SEARCH, _cache_bytes);
+    _reverse = new LazyDfa(_program, StateBuilder::REVERSE, _cache_bytes);
+  }
+
+  int id;
+  int matched = _start < 0 ? -1 : _forward->scan(str, pos, end, id);
+  if (matched > 0) {
+    matched = _reverse->scan_back(str, pos, end, start);
+  }
+
+  // fall back on the nfa if a cache is thrashing
+  if (matched < 0) {
+    _stats.fallbacks++;
+    return _nfa.search(str, pos, start, end);
+  }
+  return matched;
+}
+
+// retrieve the counters
+const LazyDfa::Stats &LazyDfa::stats() const { return _stats; }
+
+// reset the counters, apart from those describing the cache's contents
+void LazyDfa::reset_stats() {
+  _stats.hits = 0;
+  _stats.misses = 0;
+  _stats.clears = 0;
+  _stats.fallbacks = 0;
+}
+
+// Run the dfa forward from pos, reporting where the last accepting state
+// was reached and its id. Returns 1 if one was, 0 if not, and -1 if the
+// cache thrashed.
+int LazyDfa::scan(std::string_view str, size_t pos, size_t &end, int &id) {
+  size_t hits = 0;
+  bool matched = false;
+  const unsigned char *symbol = _program->symbol_map();
+  int s = _start;
+
+  // the start state may not fit if the cap is tiny
+  _thrashing = 0;
+  if (s < 0) {
+    return -1;
+  }
+
+  if (_accept[s] >= 0) {
+    matched = true;
+    end = pos;
+    id = _accept[s];
+  }
+
+  _examined = str.length() + 1;
+  for (size_t p = pos; p < str.length(); p++) {
+    unsigned char sym = symbol[(unsigned char)str[p]];
+    int n = _next[s * _stride + sym];
+
+    if (n == UNKNOWN) {
+      n = transition(s, sym);
+      if (n < 0 || _thrashing >= MAX_CLEARS) {
+        _stats.hits += hits;
+        return -1;
+      }
+    } else {
+      hits++;
+    }
+
+    if (n == DEAD) {
+      _examined = p + 1;
+      break;
+    }
+
+    s = n;
+    _scanned++;
+    if (_accept[s] >= 0) {
+      matched = true;
+      end = p + 1;
+      id = _accept[s];
+    }
+  }
+
+  _stats.hits += hits;
+  return matched;
+}
+
+// Run the dfa backward from end, no further than pos, reporting where the
+// last accepting state was reached. Returns 1 if one was, 0 if not, and -1
+// if the cache thrashed.
+int LazyDfa::scan_back(std::string_view str, size_t pos, size_t end,
+                       size_t &start) {
+  size_t hits = 0;
+  bool matched = false;
+  const unsigned char *symbol = _program->symbol_map();
+  int s = _start;
+
+  _thrashing = 0;
+  if (s < 0) {
+    return -1;
+  }
+
+  if (_accept[s] >= 0) {
+    matched = true;
+    start = end;
+  }
+
+  for (size_t p = end; p > pos; p--) {
+    unsigned char sym = symbol[(unsigned char)str[p - 1]];
+    int n = _next[s * _stride + sym];
+
+    if (n == UNKNOWN) {
+      n = transition(s, sym);
+      if (n < 0 || _thrashing >= MAX_CLEARS) {
+        _stats.hits += hits;
+        return -1;
+      }
+    } else {
+      hits++;
+    }
+
+    if (n == DEAD) {
+      break;
+    }
+
+    s = n;
+    _scanned++;
+    if (_accept[s] >= 0) {
+      matched = true;
+      start = p - 1;
+    }
+  }
+
+  _stats.hits += hits;
+  return matched;
+}
+
+// Match with the nfa instead, taking over what it examined
+bool LazyDfa::nfa_match(std::string_view str, size_t pos, size_t &end,
+                        int &id) {
+  bool matched = _nfa.match(str, pos, end, id);
+  _examined = _nfa.examined();
+  return matched;
+}
+
+// Empty the cache and rebuild the dead and start states
+void LazyDfa::clear() {
+  if (_scanned < MIN_BYTES_PER_STATE * _built) {
+    _thrashing++;
+  }
+
+  _cache.clear();
+  _keys.clear();
+  _accept.clear();
+  _next.clear();
+  _stats.states = 0;
+  _stats.bytes = 0;
+  _stats.clears++;
+  _scanned = 0;
+  _built = 0;
+
+  // the dead state has no instructions
+  _key.clear();
+  add_state();
+
+  // the start state
+  _builder.start(_key);
+  _start = add_state();
+}
+
+// Find or build the state for _key, returning -1 if it does not fit
+int LazyDfa::add_state() {
+  auto found = _cache.find(_key);
+  if (found != _cache.end()) {
+    return found->second;
+  }
+
+  // the dead state is always allowed, everything else must fit the cap
+  size_t bytes = state_bytes(_key.size(), _stride);
+  if (!_keys.empty() && _stats.bytes + bytes > _cache_bytes) {
+    return -1;
+  }
+
+  int s = _keys.size();
+  auto inserted = _cache.emplace(_key, s).first;
+  _keys.push_back(&inserted->first);
+  _accept.push_back(_builder.accept(_key));
+  _next.resize(_next.size() + _stride, UNKNOWN);
+  _stats.states++;
+  _stats.bytes += bytes;
+  _built++;
+
+  return s;
+}
+
+// Build the transition from state s on the byte class sym
+int LazyDfa::transition(int &s, unsigned char sym) {
+  unsigned char c = _program->representative(sym);
+  _stats.misses++;
+
+  // step every instruction of s over a byte of the class
+  _builder.step(*_keys[s], c, _key);
+
+  int n = add_state();
+  if (n < 0) {
+    // make room, keeping the state we are in
+    std::vector<int> next_key = _key;
+    std::vector<int> cur_key = *_keys[s];
+    clear();
+    _key = cur_key;
+    s = add_state();
+    _key = next_key;
+    n = add_state();
+    if (s < 0 || n < 0) {
+      return -1;
+    }
+  }
+
+  _next[s * _stride + sym] = n;
+  return n;
+}
@@ -0,0 +1,126 @@
+// File: lazy_dfa.h
+// Purpose: Run a compiled program as a DFA whose states are built on demand
+//          while scanning. Built states and transitions are cached, up to
+//          a memory cap, so each input byte usually costs one table lookup.
+// Author: Robert Lowe
+#ifndef LAZY_DFA_H
+#define LAZY_DFA_H
+#include <map>
+#include <vector>
+#include "matcher.h"
+#include "pike_vm.h"
+#include "program.h"
+#include "state_builder.h"
+
+class LazyDfa : public Matcher {
+public:
+  // the default memory cap of the state cache
+  static const size_t DEFAULT_CACHE_BYTES = 2 * 1024 * 1024;
+
+  // Construct a dfa to run the program, which must outlive the dfa. The
+  // state cache is cleared whenever it grows beyond cache_bytes.
+  LazyDfa(const Program *program, size_t cache_bytes = DEFAULT_CACHE_BYTES);
+
+  // free the automata built for searching
+  virtual ~LazyDfa();
+
+  // Attempt an anchored match of the string beginning at pos, reporting the
+  // end of the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end);
+
+  // Attempt an anchored match, also reporting the smallest match id among
+  // the program's match instructions accepting the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end,
+                     int &id);
+
+  // Search for the leftmost-longest match in time linear in the input. The
+  // first search creates a forward automaton which starts a match at every
+  // byte and a reverse one, each with its own cache under the same cap.
+  virtual bool search(std::string_view str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // Counters describing how well the cache is working
+  struct Stats {
+    size_t hits;      // transitions found in the cache
+    size_t misses;    // transitions which had to be built
+    size_t clears;    // times the cache was cleared to stay under the cap
+    size_t fallbacks; // matches handed to the NFA because the cache thrashed
+    size_t states;    // states currently in the cache
+    size_t bytes;     // approximate memory used by the cache
+  };
+
+  // retrieve and reset the counters
+  const Stats &stats() const;
+  void reset_stats();
+
+private:
+  // a transition which has not been built yet
+  static const int UNKNOWN = -1;
+
+  // the state which matches nothing more
+  static const int DEAD = 0;
+
+  const Program *_program;
+  size_t _cache_bytes;
+
+  // the number of transitions per state, one for each byte class
+  int _stride;
+  Stats _stats;
+
+  // the states, keyed by the sorted addresses of their NFA instructions
+  std::map<std::vector<int>, int> _cache;
+  std::vector<const std::vector<int> *> _keys;
+  std::vector<int> _accept;
+
+  // the transitions, indexed by state * _stride + byte class
+  std::vector<int> _next;
+  int _start;
+
+  // bytes scanned and states built since the cache was last cleared
+  size_t _scanned;
+  size_t _built;
+
+  // the number of thrashing clears during the current match
+  size_t _thrashing;
+
+  // builds the states, with scratch space for their keys
+  StateBuilder _builder;
+  std::vector<int> _key;
+
+  // the nfa to fall back on when the cache thrashes
+  PikeVM _nfa;
+
+  // the automata which find where a search's match ends and begins
+  LazyDfa *_forward;
+  LazyDfa *_reverse;
+
+  // construct an automaton of the given kind for the program
+  LazyDfa(const Program *program, StateBuilder::Kind kind,
+          size_t cache_bytes);
+
+  // Run the dfa forward from pos, reporting where the last accepting state
+  // was reached and its id. Returns 1 if one was, 0 if not, and -1 if the
+  // cache thrashed.
+  int scan(std::string_view str, size_t pos, size_t &end, int &id);
+
+  // Run the dfa backward from end, no further than pos, reporting where the
+  // last accepting state was reached. Returns 1 if one was, 0 if not, and
+  // -1 if the cache thrashed.
+  int scan_back(std::string_view str, size_t pos, size_t end,
+                size_t &start);
+
+  // match with the nfa instead, taking over what it examined
+  bool nfa_match(std::string_view str, size_t pos, size_t &end, int &id);
+
+  // empty the cache and rebuild the dead and start states
+  void clear();
+
+  // find or build the state for _key, returning -1 if it does not fit
+  int add_state();
+
+  // build the transition from state s on the byte class sym, which may
+  // clear the cache and so renumber s
+  int transition(int &s, unsigned char sym);
+};
+
+#endif
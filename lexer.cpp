@@ -2,6 +2,13 @@
 // Purpose: Lexer implementation
 // Author: Robert Lowe
 #include "lexer.h"
+#include "byte_set.h"
+#include "dfa.h"
+#include "lazy_dfa.h"
+#include "line_index.h"
+#include "mapped_file.h"
+#include "nfa_compiler.h"
+#include "symbol_table.h"
 
 // construct a lexer with an empty string to scan
 Lexer::Lexer() : Lexer("") {
@@ -9,71 +16,267 @@ Lexer::Lexer() : Lexer("") {
 }
 
 // construct a lexer to scan the given input string
-Lexer::Lexer(const std::string &_input) { input(_input); }
+Lexer::Lexer(const std::string &_input)
+    : _file(nullptr), _lookahead(0), _lines(nullptr), _symbols(nullptr),
+      _program(nullptr), _matcher(nullptr), _compiled(false) {
+  input(_input);
+}
 
 // destroy the lexer and deallocate all the RegexNodes
 Lexer::~Lexer() {
-  // delete all the regex nodes
+  // drop the references to the regex nodes
   for (auto &token : _tokens) {
-    delete token.second;
+    RegexNode::unref(token.second);
   }
+  clear_automaton();
+  delete _file;
+  delete _lines;
 }
 
 // set the input string to scan
 void Lexer::input(const std::string &_input) {
   this->_input = _input; // read the input string
-  this->_pos = 0;        // start at the beginning of the input string
+  this->_view = this->_input;
+  this->_pos = 0; // start at the beginning of the input string
+  if (_lines) {
+    _lines->reset();
+  }
+}
+
+// Scan a buffer owned by the caller without copying it, if every pattern
+// compiles
+bool Lexer::borrow(std::string_view buffer) {
+  if (!_compiled) {
+    compile();
+  }
+  bool borrowed = _matcher || _tokens.empty();
+
+  _input.clear();
+  _view = borrowed ? buffer : std::string_view();
+  _pos = 0;
+  if (_lines) {
+    _lines->reset();
+  }
+  return borrowed;
+}
+
+// scan a file mapped into memory
+bool Lexer::input_file(const std::string &path) {
+  if (!_file) {
+    _file = new MappedFile();
+  }
+
+  // the old input may be the file, so let go of it first
+  borrow(std::string_view());
+  if (!_file->open(path)) {
+    return false;
+  }
+
+  if (!borrow(_file->view())) {
+    _file->close();
+    return false;
+  }
+  return true;
 }
 
 // retrieve the input string to scan
-std::string Lexer::input() const { return _input; }
+std::string Lexer::input() const { return std::string(_view); }
+
+// retrieve the input without copying it
+std::string_view Lexer::view() const { return _view; }
 
 // return true if the lexer is at the end of the input
-bool Lexer::at_end() const { return _pos >= _input.length(); }
+bool Lexer::at_end() const { return _pos >= _view.length(); }
 
 // return the current position of the lexer
 int Lexer::position() const { return _pos; }
 
+// convert a position in the input to a line and a column
+void Lexer::location(size_t pos, size_t &line, size_t &column) {
+  if (!_lines) {
+    _lines = new LineIndex();
+  }
+  _lines->locate(_view, pos, line, column);
+}
+
+// intern the lexeme of every token in table
+void Lexer::intern(SymbolTable *table) { _symbols = table; }
+
 // Add a new token to the lexer
 void Lexer::add_token(int tok, RegexNode *pattern) {
+  ByteSet first;
+  int index = _tokens.size();
+
   this->_tokens.push_back(std::pair<int, RegexNode *>(tok, pattern));
+
+  // a token is never empty, so it can only begin with one of its first bytes
+  pattern->first_bytes(first);
+  for (int c = 0; c < 256; c++) {
+    if (first.contains(c)) {
+      _dispatch[c].push_back(index);
+    }
+  }
+  _compiled = false;
 }
 
-// Get the next token from the input string
+// Get the next token from the input string. An interned lexeme is not
+// copied, as the table holds it already.
 Lexer::Token Lexer::next() {
-  Token token;          // the result of the lexing process
-  size_t final_pos = 0; // the position of the first character beyond the token
+  TokenView view = next_view();
+  Token token;
 
-  token.tok = Lexer::INVALID;
+  token.tok = view.tok;
+  token.pos = view.pos;
+  if (!_symbols) {
+    token.lexeme = std::string(view.lexeme);
+  }
+  token.symbol = view.symbol;
+  return token;
+}
+
+// Get the next token without copying its lexeme
+Lexer::TokenView Lexer::next_view() {
+  TokenView token; // the result of the lexing process
+  size_t end;      // the first character beyond the token
 
   // note the start position of the token
   token.pos = _pos;
+  token.symbol = -1;
 
   // if we have reached the end of the input string, return the end-of-file
   // token
   if (at_end()) {
     token.tok = Lexer::END_OF_INPUT;
-    token.lexeme = "";
+    token.lexeme = std::string_view();
     return token;
   }
 
-  // look for the longest possible match, but break ties by precedence
-  for (auto pattern : this->_tokens) {
-    size_t pos = this->_pos;
-    if (pattern.second->match(_input, pos) && pos > final_pos) {
-      final_pos = pos;
-      token.tok = pattern.first;
-    }
+  // update the _pos and the lexeme
+  token.tok = scan(end);
+  token.lexeme = _view.substr(token.pos, end - token.pos);
+  if (_symbols) {
+    token.symbol = _symbols->intern(token.lexeme);
   }
+  _pos = end;
 
-  // update the _pos and the lexeme
-  if (token.tok != Lexer::INVALID) {
-    token.lexeme = _input.substr(token.pos, final_pos - token.pos);
-    _pos = final_pos;
+  return token;
+}
+
+// Get up to max tokens at once, storing them as parallel arrays
+size_t Lexer::next_batch(int *tok, size_t *pos, size_t *len, size_t max) {
+  size_t count = 0;
+  size_t end;
+
+  while (count < max && _pos < _view.length()) {
+    tok[count] = scan(end);
+    pos[count] = _pos;
+    len[count] = end - _pos;
+    _pos = end;
+    count++;
+  }
+
+  return count;
+}
+
+// Get up to max tokens at once, storing the token and its symbol
+size_t Lexer::next_symbols(int *tok, int *symbol, size_t max) {
+  size_t count = 0;
+  size_t end;
+
+  if (!_symbols) {
+    return 0;
+  }
+
+  while (count < max && _pos < _view.length()) {
+    tok[count] = scan(end);
+    symbol[count] = _symbols->intern(_view.substr(_pos, end - _pos));
+    _pos = end;
+    count++;
+  }
+
+  return count;
+}
+
+// one past the last input position examined to find the most recent token
+size_t Lexer::lookahead() const { return _lookahead; }
+
+// Match a token at _pos
+int Lexer::scan(size_t &end) {
+  int tok = Lexer::INVALID;
+  size_t final_pos = _pos; // the first character beyond the token
+
+  if (!_compiled) {
+    compile();
+  }
+
+  // only the patterns which can begin with this byte are candidates
+  const std::vector<int> &candidates = _dispatch[(unsigned char)_view[_pos]];
+
+  if (candidates.empty()) {
+    // nothing can match here
+    _lookahead = _pos + 1;
+  } else if (_matcher) {
+    // one pass over the input finds the longest match, and the lowest match
+    // id among the patterns accepting it breaks ties by precedence
+    size_t match_end;
+    int id;
+    if (_matcher->match(_view, _pos, match_end, id) && match_end > final_pos) {
+      final_pos = match_end;
+      tok = _tokens[id].first;
+    }
+    _lookahead = _matcher->examined();
   } else {
-    token.lexeme = _input.substr(token.pos, 1);
-    _pos++;
+    // the tree patterns need a string, so a buffer borrowed before they
+    // were added is copied after all
+    if (_view.data() != _input.data()) {
+      _input.assign(_view);
+      _view = _input;
+    }
+
+    // look for the longest possible match, but break ties by precedence
+    for (int index : candidates) {
+      size_t pos = this->_pos;
+      if (_tokens[index].second->match(_input, pos) && pos > final_pos) {
+        final_pos = pos;
+        tok = _tokens[index].first;
+      }
+    }
+    _lookahead = _view.length() + 1;
   }
 
-  return token;
-}
\ No newline at end of file
+  // an invalid token consumes one character
+  end = tok != Lexer::INVALID ? final_pos : _pos + 1;
+  return tok;
+}
+
+// (re)build the combined automaton
+void Lexer::compile() {
+  std::vector<RegexNode *> patterns;
+  NfaCompiler compiler;
+
+  clear_automaton();
+  _compiled = true;
+
+  for (auto &token : _tokens) {
+    patterns.push_back(token.second);
+  }
+  _program = compiler.compile(patterns);
+  if (!_program) {
+    return;
+  }
+
+  // token sets are fixed once lexing starts, so a full table is worth
+  // building; very large ones are explored lazily instead
+  _matcher = Dfa::build(_program);
+  if (!_matcher) {
+    _matcher = new LazyDfa(_program);
+  }
+}
+
+// release the combined automaton
+void Lexer::clear_automaton() {
+  delete _matcher;
+  delete _program;
+  _matcher = nullptr;
+  _program = nullptr;
+}
@@ -5,10 +5,16 @@
 #ifndef LEXER_H
 #define LEXER_H
 #include <string>
+#include <string_view>
 #include <vector>
 #include <utility>
 #include "regex_node.h"
 
+class Program;
+class Matcher;
+class MappedFile;
+class LineIndex;
+class SymbolTable;
 
 class Lexer {
 public:
@@ -24,15 +30,37 @@ public:
   // set the input string to scan
   void input(const std::string& _input);
 
+  // Scan a buffer owned by the caller without copying it. The buffer must
+  // outlive the scan, and so must the lexemes of any TokenView. Patterns
+  // which cannot be compiled are matched as trees, which need the input in
+  // a string, so the buffer is only borrowed if every pattern compiles.
+  // Otherwise this returns false, leaving the input empty, and the buffer
+  // must be copied in with input(). A pattern added while a buffer is
+  // borrowed must compile as well, or the buffer is copied after all.
+  bool borrow(std::string_view buffer);
+
+  // Scan a file mapped into memory rather than read into a string.
+  // Returns false, leaving the input empty, if the file cannot be mapped,
+  // or if some pattern cannot be compiled and so could only scan a copy.
+  bool input_file(const std::string &path);
+
   // retrieve the input string to scan
   std::string input() const;
 
+  // retrieve the input without copying it
+  std::string_view view() const;
+
   // return true if the lexer is at the end of the input
   bool at_end() const;
 
   // return the current position of the lexer
   int position() const;
 
+  // Convert a position in the input to a line and a column, both counted
+  // from 1. The newlines are indexed on first use and only as far as
+  // needed, so repeated lookups stay cheap on large inputs.
+  void location(size_t pos, size_t &line, size_t &column);
+
   // The tokens emitted by the lexer
   // Note there are two pre-defined tokens:
   //   - END_OF_INPUT  -1
@@ -41,20 +69,86 @@ public:
   struct Token {
     int tok;             // numeric token
     size_t pos;          // position of the token in the input string
-    std::string lexeme;  // matched lexeme
+    std::string lexeme;  // matched lexeme, left empty when interning
+    int symbol;          // interned lexeme, or -1 when not interning
   };
+
+  // A token whose lexeme points into the input rather than owning a copy
+  struct TokenView {
+    int tok;                 // numeric token
+    size_t pos;              // position of the token in the input string
+    std::string_view lexeme; // matched lexeme
+    int symbol;              // interned lexeme, or -1 when not interning
+  };
+
   static const int END_OF_INPUT = -1;
   static const int INVALID = -2;
 
+  // Intern the lexeme of every token in table, so that each token carries
+  // the symbol of its lexeme. A Token then carries no copy of the lexeme,
+  // which is the table's name for the symbol. The table must outlive the
+  // lexer's use of it. A null table stops interning.
+  void intern(SymbolTable *table);
+
   // Add a new token to the lexer
   void add_token(int tok, RegexNode *pattern);
 
   // Get the next token from the input string
   Token next();
 
+  // Get the next token without copying its lexeme. When all the patterns
+  // can be compiled, this performs no allocation.
+  TokenView next_view();
+
+  // Get up to max tokens at once, storing them as parallel arrays: the
+  // numeric token in tok, and the extent of the lexeme in pos and len.
+  // Returns the number of tokens stored, which is zero only at the end of
+  // the input. The end-of-input token itself is never stored.
+  size_t next_batch(int *tok, size_t *pos, size_t *len, size_t max);
+
+  // Get up to max tokens at once, storing only the numeric token and the
+  // symbol of its lexeme. This requires a symbol table. Returns the number
+  // of tokens stored, which is zero only at the end of the input.
+  size_t next_symbols(int *tok, int *symbol, size_t max);
+
+  // One past the last input position examined to find the most recent
+  // token, where the end of the input counts as position length. The token
+  // cannot change unless the input before this position does. Patterns
+  // which are not compiled are assumed to examine the whole input.
+  size_t lookahead() const;
+
 private:
-  std::string _input;
+  std::string _input;     // the input, unless it is borrowed
+  std::string_view _view; // the input being scanned
+  MappedFile *_file;      // the mapped input file, if any
+  size_t _lookahead;      // the extent examined for the last token
+  LineIndex *_lines;      // the lines of the input, once asked for
+  SymbolTable *_symbols;  // the table lexemes are interned in, if any
   size_t _pos;
   std::vector<std::pair<int, RegexNode*>> _tokens;
+
+  // For each byte, the indices in _tokens of the patterns which can begin
+  // with it, in the order they were added
+  std::vector<int> _dispatch[256];
+
+  // All the token patterns compiled into one automaton, where the match id
+  // of each pattern is its index in _tokens. This is built on the first
+  // call to next() after a token is added. If some pattern cannot be
+  // compiled, _matcher is left null and the patterns are tried one at a
+  // time.
+  Program *_program;
+  Matcher *_matcher;
+  bool _compiled;
+
+  // Match a token at _pos, which must not be at the end of the input.
+  // Returns the token and stores the end of its lexeme in end. An invalid
+  // token is one byte long.
+  int scan(size_t &end);
+
+  // (re)build the combined automaton
+  void compile();
+
+  // release the combined automaton
+  void clear_automaton();
 };
 #endif
\ No newline at end of file
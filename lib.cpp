@@ -1,9 +1,67 @@
 #include "regex_node.h"
 #include "regex_parser.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "backtracker.h"
+#include "lazy_dfa.h"
+#include "dfa.h"
+#include "program_node.h"
+#include "flat_regex.h"
+#include "lib.h"
 #include <string>
 
-RegexNode *make_regex(const std::string &str) {
+RegexOptions::RegexOptions(RegexMode mode)
+    : mode(mode), dfa_cache_bytes(LazyDfa::DEFAULT_CACHE_BYTES),
+      dfa_state_limit(Dfa::DEFAULT_STATE_LIMIT), arena(nullptr),
+      captures(false), backtrack_bytes(Backtracker::DEFAULT_BUDGET_BYTES) {}
+
+RegexNode *make_regex(const std::string &str, RegexMode mode) {
+  return make_regex(str, RegexOptions(mode));
+}
+
+RegexNode *make_regex(const std::string &str, const RegexOptions &options) {
   RegexParser parser;
+  parser.captures(options.captures);
+  return make_regex(parser.parse(str, options.arena), options);
+}
+
+RegexNode *make_regex(RegexNode *tree, const RegexOptions &options) {
+  if (options.mode == REGEX_TREE) {
+    return tree;
+  }
+
+  // flatten the tree, keeping it if that is not possible
+  if (options.mode == REGEX_FLAT) {
+    RegexNode *flat = tree ? FlatRegex::build(tree) : nullptr;
+    if (!flat) {
+      return tree;
+    }
+    delete tree;
+    return flat;
+  }
+
+  // compile the tree, keeping it if that is not possible
+  NfaCompiler compiler;
+  Program *program = compiler.compile(tree);
+  if (!program) {
+    return tree;
+  }
+  delete tree;
+
+  // choose the engine to run the program
+  Matcher *matcher = nullptr;
+  if (options.mode == REGEX_DFA) {
+    // this fails if the dfa would be too big
+    matcher = Dfa::build(program, options.dfa_state_limit);
+  }
+  if (!matcher &&
+      (options.mode == REGEX_LAZY_DFA || options.mode == REGEX_DFA)) {
+    matcher = new LazyDfa(program, options.dfa_cache_bytes);
+  }
+  if (!matcher) {
+    matcher = new PikeVM(program);
+  }
 
-  return parser.parse(str);
-}
\ No newline at end of file
+  return new ProgramNode(program, matcher, options.backtrack_bytes,
+                         options.dfa_state_limit);
+}
@@ -1,4 +1,42 @@
+#ifndef LIB_H
+#define LIB_H
+#include <cstddef>
+#include <string>
+
 // RegexNode class prototype
 class RegexNode;
+class NodeArena;
+
+// The ways make_regex can build a regular expression
+enum RegexMode {
+  REGEX_TREE,     // match by walking the parsed tree of nodes
+  REGEX_NFA,      // compile the tree to an NFA program run by a Pike VM
+  REGEX_LAZY_DFA, // run the compiled program as a lazily built DFA
+  REGEX_DFA,      // build the whole minimized DFA ahead of time
+  REGEX_FLAT      // match the tree flattened into one array of nodes
+};
+
+// Options for building a regular expression
+struct RegexOptions {
+  RegexMode mode;
+  size_t dfa_cache_bytes; // memory cap of the lazy DFA's state cache
+  size_t dfa_state_limit; // most states REGEX_DFA, or the tagged DFA which
+                          // finds capture groups, may build before falling
+                          // back to a slower engine
+  NodeArena *arena;       // if set, the parsed nodes are placed in it, and
+                          // a REGEX_TREE result must not outlive it
+  bool captures;          // whether parenthesized regexes are capture groups
+  size_t backtrack_bytes; // most memory a compiled regex may use to find
+                          // capture groups by backtracking
+
+  RegexOptions(RegexMode mode = REGEX_TREE);
+};
+
+RegexNode* make_regex(const std::string &str, RegexMode mode = REGEX_TREE);
+RegexNode* make_regex(const std::string &str, const RegexOptions &options);
+
+// Build a regular expression from a tree already parsed, which it takes
+// over. The arena option is not used, as the tree is already built.
+RegexNode* make_regex(RegexNode *tree, const RegexOptions &options);
 
-RegexNode* make_regex(const std::string &str);
\ No newline at end of file
+#endif
@@ -0,0 +1,65 @@
+// File: line_index.cpp
+// Purpose: Convert byte offsets in a text to line and column numbers. The
+//          newlines are found lazily, only as far as the offsets asked
+//          about, and each lookup is a binary search.
+// Author: Robert Lowe
+#include "line_index.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// construct an index of an empty text
+LineIndex::LineIndex() { reset(); }
+
+// forget the lines found so far
+void LineIndex::reset() {
+  _starts.assign(1, 0);
+  _scanned = 0;
+}
+
+// Find the lines of text up to offset. Sixteen bytes at a time are compared
+// against a newline, and only the positions of the newlines are visited.
+void LineIndex::extend(std::string_view text, size_t offset) {
+  size_t end = std::min(offset + 1, text.length());
+  size_t p = _scanned;
+
+  if (p >= end) {
+    return;
+  }
+
+#if defined(__SSE2__)
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; p + 16 <= end; p += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)(text.data() + p));
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+    while (mask) {
+      _starts.push_back(p + __builtin_ctz(mask) + 1);
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  for (; p < end; p++) {
+    if (text[p] == '\n') {
+      _starts.push_back(p + 1);
+    }
+  }
+
+  _scanned = p;
+}
+
+// Convert offset to a line and a column
+void LineIndex::locate(std::string_view text, size_t offset, size_t &line,
+                       size_t &column) {
+  extend(text, offset);
+
+  // the line is the last one beginning at or before offset
+  line = std::upper_bound(_starts.begin(), _starts.end(), offset) -
+         _starts.begin();
+  column = offset - _starts[line - 1] + 1;
+}
+
+// the number of lines found so far
+size_t LineIndex::lines() const { return _starts.size(); }
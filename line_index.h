@@ -0,0 +1,40 @@
+// File: line_index.h
+// Purpose: Convert byte offsets in a text to line and column numbers. The
+//          newlines are found lazily, only as far as the offsets asked
+//          about, and each lookup is a binary search.
+// Author: Robert Lowe
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+class LineIndex {
+public:
+  // construct an index of an empty text
+  LineIndex();
+
+  // forget the lines found so far, ready to index a new text
+  void reset();
+
+  // Find the lines of text up to offset, if they are not known already.
+  // The text must not change between calls, apart from growing.
+  void extend(std::string_view text, size_t offset);
+
+  // Convert offset to a line and a column, both counted from 1. The column
+  // counts bytes.
+  void locate(std::string_view text, size_t offset, size_t &line,
+              size_t &column);
+
+  // the number of lines found so far
+  size_t lines() const;
+
+private:
+  // the offset at which each line begins
+  std::vector<size_t> _starts;
+
+  // the length of text scanned for newlines so far
+  size_t _scanned;
+};
+
+#endif
@@ -0,0 +1,98 @@
+// File: line_scanner.cpp
+// Purpose: Find the lines of a buffer which match a regular expression.
+// Author: Robert Lowe
+#include "line_scanner.h"
+#include "literal_analysis.h"
+#include "mapped_file.h"
+#include "program_node.h"
+#include "regex_parser.h"
+#include <cstring>
+
+// Construct a scanner for the pattern, built with the given options. The
+// literal is found in the parsed tree before the regex is built from it.
+LineScanner::LineScanner(const std::string &pattern,
+                         const RegexOptions &options) {
+  RegexParser parser;
+  parser.captures(options.captures);
+  RegexNode *tree = parser.parse(pattern, options.arena);
+
+  // a newline can never be part of a matching line
+  std::string literal = tree ? required_literal(tree) : "";
+  if (literal.find('\n') != std::string::npos) {
+    literal.clear();
+  }
+  _scanner = LiteralScanner(literal);
+
+  _regex = make_regex(tree, options);
+  _program = dynamic_cast<ProgramNode *>(_regex);
+}
+
+// destroy the scanner and its regex
+LineScanner::~LineScanner() { delete _regex; }
+
+// the literal which prefilters the lines
+const std::string &LineScanner::literal() const { return _scanner.literal(); }
+
+// Find the next line at or after pos which contains a match.
+bool LineScanner::next(std::string_view buf, size_t &pos, size_t &start,
+                       size_t &end) {
+  const char *data = buf.data();
+
+  while (pos < buf.length()) {
+    // skip straight to the next line holding the literal
+    size_t hit = _scanner.find(buf, pos);
+    if (hit == LiteralScanner::NOT_FOUND) {
+      pos = buf.length();
+      return false;
+    }
+
+    // widen the hit to its line
+    const void *nl = memrchr(data + pos, '\n', hit - pos);
+    start = nl ? (const char *)nl - data + 1 : pos;
+    nl = memchr(data + hit, '\n', buf.length() - hit);
+    end = nl ? (const char *)nl - data : buf.length();
+    pos = nl ? end + 1 : end;
+
+    if (matches(buf.substr(start, end - start))) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// count the matching lines in the buffer
+size_t LineScanner::count(std::string_view buf) {
+  size_t pos = 0, start, end, result = 0;
+
+  while (next(buf, pos, start, end)) {
+    result++;
+  }
+
+  return result;
+}
+
+// count the matching lines of a file mapped into memory
+bool LineScanner::count_file(const std::string &path, size_t &result) {
+  MappedFile file;
+
+  if (!file.open(path)) {
+    return false;
+  }
+
+  result = count(file.view());
+  return true;
+}
+
+// return true if the line contains a match
+bool LineScanner::matches(std::string_view line) {
+  size_t start, end;
+
+  if (_program) {
+    return _program->find(line, 0, start, end);
+  }
+
+  // the tree needs a string of its own, and a pattern which did not parse
+  // matches nothing
+  return _regex && _regex->search(std::string(line), 0, start, end);
+}
@@ -0,0 +1,51 @@
+// File: line_scanner.h
+// Purpose: Find the lines of a buffer which match a regular expression.
+//          Only the lines holding the literal every match requires are
+//          given to the regex, so most of the buffer is skipped by a fast
+//          literal scan.
+// Author: Robert Lowe
+#ifndef LINE_SCANNER_H
+#define LINE_SCANNER_H
+#include <string>
+#include <string_view>
+#include "literal_scanner.h"
+#include "regex_node.h"
+#include "lib.h"
+
+class ProgramNode;
+
+class LineScanner {
+public:
+  // construct a scanner for the pattern, built with the given options
+  LineScanner(const std::string &pattern,
+              const RegexOptions &options = RegexOptions(REGEX_LAZY_DFA));
+
+  // destroy the scanner and its regex
+  virtual ~LineScanner();
+
+  // the literal which prefilters the lines, possibly empty
+  const std::string &literal() const;
+
+  // Find the next line at or after pos which contains a match. The line is
+  // reported as start..end, not counting its newline, and pos is moved to
+  // the beginning of the line after it. pos must be at the beginning of a
+  // line. Returns false when no more lines match.
+  bool next(std::string_view buf, size_t &pos, size_t &start, size_t &end);
+
+  // count the matching lines in the buffer
+  size_t count(std::string_view buf);
+
+  // Count the matching lines of a file, which is mapped into memory rather
+  // than read. Returns false if the file cannot be mapped.
+  bool count_file(const std::string &path, size_t &result);
+
+private:
+  LiteralScanner _scanner;
+  RegexNode *_regex;
+  ProgramNode *_program;
+
+  // return true if the line contains a match
+  bool matches(std::string_view line);
+};
+
+#endif
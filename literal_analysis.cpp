@@ -0,0 +1,172 @@
+// File: literal_analysis.cpp
+// Purpose: Find the literal strings which every match of a tree of
+//          RegexNodes must contain.
+// Author: Robert Lowe
+#include "literal_analysis.h"
+#include "byte_set.h"
+#include "regex.h"
+#include <unordered_map>
+
+//////////////////////////////////////////
+// Static Helper Functions
+//////////////////////////////////////////
+
+// the info of a node which matches exactly str
+static LiteralInfo exact(const std::string &str) {
+  LiteralInfo result;
+  result.exact = true;
+  result.str = str;
+  result.prefix = str;
+  result.suffix = str;
+  result.required = str;
+  return result;
+}
+
+// the info of a node we know nothing about
+static LiteralInfo unknown() {
+  LiteralInfo result;
+  result.exact = false;
+  return result;
+}
+
+// the longer of two strings, preferring the first
+static const std::string &longer(const std::string &a, const std::string &b) {
+  return b.length() > a.length() ? b : a;
+}
+
+// the info of a followed by b
+static LiteralInfo concat(const LiteralInfo &a, const LiteralInfo &b) {
+  if (a.exact && b.exact) {
+    return exact(a.str + b.str);
+  }
+
+  LiteralInfo result = unknown();
+  result.prefix = a.exact ? a.str + b.prefix : a.prefix;
+  result.suffix = b.exact ? a.suffix + b.str : b.suffix;
+
+  // the required literal may straddle the boundary
+  result.required = longer(longer(a.required, b.required), a.suffix + b.prefix);
+  result.required = longer(result.required, longer(result.prefix, result.suffix));
+  return result;
+}
+
+// the info of a choice between a and b
+static LiteralInfo alternate(const LiteralInfo &a, const LiteralInfo &b) {
+  if (a.exact && b.exact && a.str == b.str) {
+    return a;
+  }
+
+  LiteralInfo result = unknown();
+
+  // keep the common prefix and suffix
+  size_t n = 0;
+  while (n < a.prefix.length() && n < b.prefix.length() &&
+         a.prefix[n] == b.prefix[n]) {
+    n++;
+  }
+  result.prefix = a.prefix.substr(0, n);
+
+  n = 0;
+  while (n < a.suffix.length() && n < b.suffix.length() &&
+         a.suffix[a.suffix.length() - 1 - n] ==
+             b.suffix[b.suffix.length() - 1 - n]) {
+    n++;
+  }
+  result.suffix = a.suffix.substr(a.suffix.length() - n);
+
+  result.required = longer(result.prefix, result.suffix);
+  return result;
+}
+
+// the info already found for the shared nodes of a tree
+typedef std::unordered_map<RegexNode *, LiteralInfo> LiteralCache;
+
+static LiteralInfo analyze_node(RegexNode *node, LiteralCache &cache);
+
+// Analyze the subtree rooted at node.
+static LiteralInfo analyze(RegexNode *node, LiteralCache &cache) {
+  ByteSet set;
+
+  if (!node) {
+    return unknown();
+  }
+
+  // single byte nodes are literals when they match one byte
+  if (node->byte_set(set)) {
+    for (int c = 0; set.count() == 1 && c < 256; c++) {
+      if (set.contains(c)) {
+        return exact(std::string(1, (char)c));
+      }
+    }
+    return unknown();
+  }
+
+  if (LiteralNode *literal = dynamic_cast<LiteralNode *>(node)) {
+    return exact(std::string(literal->text()));
+  }
+
+  if (GroupNode *group = dynamic_cast<GroupNode *>(node)) {
+    LiteralInfo result = exact("");
+    for (auto child : group->nodes()) {
+      result = concat(result, analyze_node(child, cache));
+    }
+    return result;
+  }
+
+  if (OrNode *alt = dynamic_cast<OrNode *>(node)) {
+    if (alt->nodes().empty()) {
+      return unknown();
+    }
+    LiteralInfo result = analyze_node(alt->nodes()[0], cache);
+    for (size_t i = 1; i < alt->nodes().size(); i++) {
+      result = alternate(result, analyze_node(alt->nodes()[i], cache));
+    }
+    return result;
+  }
+
+  // a capture matches what its node matches
+  if (CaptureNode *capture = dynamic_cast<CaptureNode *>(node)) {
+    return analyze_node(capture->node(), cache);
+  }
+
+  // one or more keeps everything but exactness
+  if (OneNode *one = dynamic_cast<OneNode *>(node)) {
+    LiteralInfo result = analyze_node(one->node(), cache);
+    result.exact = false;
+    result.str.clear();
+    return result;
+  }
+
+  // zero or more, optional and anything else may match nothing useful
+  return unknown();
+}
+
+// Analyze a node, once for each node shared by several parents
+static LiteralInfo analyze_node(RegexNode *node, LiteralCache &cache) {
+  if (!node || node->references() == 1) {
+    return analyze(node, cache);
+  }
+
+  auto found = cache.find(node);
+  if (found != cache.end()) {
+    return found->second;
+  }
+  LiteralInfo result = analyze(node, cache);
+  cache[node] = result;
+  return result;
+}
+
+//////////////////////////////////////////
+// Analysis Functions
+//////////////////////////////////////////
+
+// Analyze the tree rooted at node.
+LiteralInfo analyze_literals(RegexNode *node) {
+  LiteralCache cache;
+  return analyze_node(node, cache);
+}
+
+// The longest literal the analysis finds in every match of the tree.
+std::string required_literal(RegexNode *node) {
+  return analyze_literals(node).required;
+}
@@ -0,0 +1,27 @@
+// File: literal_analysis.h
+// Purpose: Find the literal strings which every match of a tree of
+//          RegexNodes must contain.
+// Author: Robert Lowe
+#ifndef LITERAL_ANALYSIS_H
+#define LITERAL_ANALYSIS_H
+#include <string>
+#include "regex_node.h"
+
+// What is known about the literals in the matches of a node
+struct LiteralInfo {
+  bool exact;           // true if the node only ever matches str
+  std::string str;      // the exact match
+  std::string prefix;   // every match begins with this
+  std::string suffix;   // every match ends with this
+  std::string required; // every match contains this
+};
+
+// Analyze the tree rooted at node. Nodes the analysis does not know about
+// are assumed to match anything.
+LiteralInfo analyze_literals(RegexNode *node);
+
+// The longest literal the analysis finds in every match of the tree.
+// Returns an empty string if there is none.
+std::string required_literal(RegexNode *node);
+
+#endif
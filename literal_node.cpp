@@ -0,0 +1,74 @@
+// File: literal_node.cpp
+// Purpose: A node which matches a literal string of bytes.
+// Author: Robert Lowe
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "literal_node.h"
+#include "byte_set.h"
+#include "nfa_compiler.h"
+#include "node_arena.h"
+
+// construct a literal node, stored in the node arena in scope if any
+LiteralNode::LiteralNode(const std::string &text)
+    : _text(text, NodeArena::resource()) {}
+
+// Attempt to match the string beginning at the given position.
+bool LiteralNode::match(const std::string &str, size_t &pos) {
+  if (pos > str.length() || str.length() - pos < _text.length() ||
+      std::memcmp(str.data() + pos, _text.data(), _text.length()) != 0) {
+    return false;
+  }
+
+  pos += _text.length();
+  return true;
+}
+
+// Search for the next occurrence of the literal
+bool LiteralNode::search(const std::string &str, size_t pos, size_t &start,
+                         size_t &end) {
+  if (pos > str.length()) {
+    return false;
+  }
+
+  size_t found = std::string_view(str).find(_text, pos);
+  if (found == std::string::npos) {
+    return false;
+  }
+
+  start = found;
+  end = found + _text.length();
+  return true;
+}
+
+// A literal of one byte matches the set holding only that byte
+bool LiteralNode::byte_set(ByteSet &set) {
+  if (_text.length() != 1) {
+    return false;
+  }
+
+  set.add(_text[0]);
+  return true;
+}
+
+// A literal begins with its first byte, and is only empty if it has none.
+bool LiteralNode::first_bytes(ByteSet &set) {
+  if (_text.empty()) {
+    return true;
+  }
+
+  set.add(_text[0]);
+  return false;
+}
+
+// Compile the literal as a chain of characters
+bool LiteralNode::compile(NfaCompiler &compiler) {
+  for (char c : _text) {
+    compiler.emit_char(c);
+  }
+
+  return true;
+}
+
+// retrieve the literal
+const std::pmr::string &LiteralNode::text() const { return _text; }
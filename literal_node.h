@@ -0,0 +1,38 @@
+// File: literal_node.h
+// Purpose: A node which matches a literal string of bytes.
+// Author: Robert Lowe
+#ifndef LITERAL_NODE_H
+#define LITERAL_NODE_H
+#include <memory_resource>
+#include <string>
+#include "regex_node.h"
+
+class LiteralNode : public RegexNode {
+public:
+  // construct a literal node, stored in the node arena in scope if any
+  LiteralNode(const std::string &text);
+
+  // Attempt to match the string beginning at the given position.
+  virtual bool match(const std::string &str, size_t &pos);
+
+  // search for the next occurrence of the literal
+  virtual bool search(const std::string &str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // a literal of one byte matches the set holding only that byte
+  virtual bool byte_set(ByteSet &set);
+
+  // the bytes which can begin a match, and whether it may be empty
+  virtual bool first_bytes(ByteSet &set);
+
+  // compile the literal as a chain of characters
+  virtual bool compile(NfaCompiler &compiler);
+
+  // retrieve the literal
+  const std::pmr::string &text() const;
+
+private:
+  std::pmr::string _text;
+};
+
+#endif
@@ -0,0 +1,120 @@
+// File: literal_scanner.cpp
+// Purpose: Find a literal string in a buffer.
+// Author: Robert Lowe
+#include "literal_scanner.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LITERAL_SCANNER_X86
+#endif
+
+const size_t LiteralScanner::NOT_FOUND;
+
+//////////////////////////////////////////
+// Static Helper Functions
+//////////////////////////////////////////
+
+// The scalar search, used for short buffers, for the tails of the vector
+// searches, and on machines without them.
+static const char *find_scalar(const char *begin, const char *end,
+                               const std::string &lit) {
+  const void *found = memmem(begin, end - begin, lit.data(), lit.length());
+  return (const char *)found;
+}
+
+#ifdef LITERAL_SCANNER_X86
+// Compare the first and last bytes of the literal against 16 candidate
+// positions at once, and check the rest of the literal only where both
+// agree.
+__attribute__((target("sse2"))) static const char *
+find_sse2(const char *begin, const char *end, const std::string &lit) {
+  size_t n = lit.length();
+  const __m128i first = _mm_set1_epi8(lit[0]);
+  const __m128i last = _mm_set1_epi8(lit[n - 1]);
+  const char *p = begin;
+
+  for (; p + 16 + n - 1 <= end; p += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i *)p);
+    __m128i b = _mm_loadu_si128((const __m128i *)(p + n - 1));
+    unsigned mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+
+    while (mask) {
+      int i = __builtin_ctz(mask);
+      if (n <= 2 || memcmp(p + i + 1, lit.data() + 1, n - 2) == 0) {
+        return p + i;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return find_scalar(p, end, lit);
+}
+
+// The same search as find_sse2, 32 positions at a time.
+__attribute__((target("avx2"))) static const char *
+find_avx2(const char *begin, const char *end, const std::string &lit) {
+  size_t n = lit.length();
+  const __m256i first = _mm256_set1_epi8(lit[0]);
+  const __m256i last = _mm256_set1_epi8(lit[n - 1]);
+  const char *p = begin;
+
+  for (; p + 32 + n - 1 <= end; p += 32) {
+    __m256i a = _mm256_loadu_si256((const __m256i *)p);
+    __m256i b = _mm256_loadu_si256((const __m256i *)(p + n - 1));
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(
+        _mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+
+    while (mask) {
+      int i = __builtin_ctz(mask);
+      if (n <= 2 || memcmp(p + i + 1, lit.data() + 1, n - 2) == 0) {
+        return p + i;
+      }
+      mask &= mask - 1;
+    }
+  }
+
+  return find_sse2(p, end, lit);
+}
+#endif
+
+//////////////////////////////////////////
+// LiteralScanner Methods
+//////////////////////////////////////////
+
+// construct a scanner for the given literal
+LiteralScanner::LiteralScanner(const std::string &literal)
+    : _literal(literal) {}
+
+// retrieve the literal
+const std::string &LiteralScanner::literal() const { return _literal; }
+
+// Return the position of the first occurrence of the literal at or after pos
+size_t LiteralScanner::find(std::string_view str, size_t pos) const {
+  if (pos > str.length()) {
+    return NOT_FOUND;
+  }
+  if (_literal.empty()) {
+    return pos;
+  }
+
+  const char *begin = str.data() + pos;
+  const char *end = str.data() + str.length();
+  const char *found;
+
+  if (_literal.length() == 1) {
+    // memchr is already vectorized
+    found = (const char *)memchr(begin, _literal[0], end - begin);
+  } else {
+#ifdef LITERAL_SCANNER_X86
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    found = avx2 ? find_avx2(begin, end, _literal)
+                 : find_sse2(begin, end, _literal);
+#else
+    found = find_scalar(begin, end, _literal);
+#endif
+  }
+
+  return found ? found - str.data() : NOT_FOUND;
+}
@@ -0,0 +1,30 @@
+// File: literal_scanner.h
+// Purpose: Find a literal string in a buffer. On x86 the search compares
+//          the first and last bytes of the literal against 16 or 32
+//          positions at a time with SSE2 or AVX2.
+// Author: Robert Lowe
+#ifndef LITERAL_SCANNER_H
+#define LITERAL_SCANNER_H
+#include <string>
+#include <string_view>
+
+class LiteralScanner {
+public:
+  // returned by find when the literal is absent
+  static const size_t NOT_FOUND = std::string_view::npos;
+
+  // construct a scanner for the given literal
+  LiteralScanner(const std::string &literal = "");
+
+  // retrieve the literal
+  const std::string &literal() const;
+
+  // Return the position of the first occurrence of the literal at or after
+  // pos, or NOT_FOUND.
+  size_t find(std::string_view str, size_t pos = 0) const;
+
+private:
+  std::string _literal;
+};
+
+#endif
@@ -0,0 +1,68 @@
+// File: mapped_file.cpp
+// Purpose: A file mapped read-only into memory, so that lexers and matchers
+//          can scan it in place without reading it into a string.
+// Author: Robert Lowe
+#include "mapped_file.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// construct a mapping of no file
+MappedFile::MappedFile() : _data(nullptr), _size(0), _open(false) {}
+
+// unmap the file
+MappedFile::~MappedFile() { close(); }
+
+// Map the file at path read-only
+bool MappedFile::open(const std::string &path) {
+  struct stat st;
+
+  close();
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  if (fstat(fd, &st) < 0) {
+    ::close(fd);
+    return false;
+  }
+
+  // an empty file cannot be mapped, but it is still a file
+  if (st.st_size > 0) {
+    void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    madvise(addr, st.st_size, MADV_SEQUENTIAL);
+    _data = static_cast<const char *>(addr);
+    _size = st.st_size;
+  }
+
+  // the mapping holds its own reference to the file
+  ::close(fd);
+  _open = true;
+  return true;
+}
+
+// unmap the file
+void MappedFile::close() {
+  if (_data) {
+    munmap(const_cast<char *>(_data), _size);
+  }
+  _data = nullptr;
+  _size = 0;
+  _open = false;
+}
+
+// return true if a file is mapped
+bool MappedFile::is_open() const { return _open; }
+
+// the bytes of the file
+const char *MappedFile::data() const { return _data; }
+size_t MappedFile::size() const { return _size; }
+std::string_view MappedFile::view() const {
+  return std::string_view(_data, _size);
+}
@@ -0,0 +1,45 @@
+// File: mapped_file.h
+// Purpose: A file mapped read-only into memory, so that lexers and matchers
+//          can scan it in place without reading it into a string.
+// Author: Robert Lowe
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+class MappedFile {
+public:
+  // construct a mapping of no file
+  MappedFile();
+
+  // unmap the file
+  virtual ~MappedFile();
+
+  // Map the file at path read-only, replacing any earlier mapping. The
+  // kernel is advised the file will be read sequentially. Returns false if
+  // the file cannot be opened or mapped.
+  bool open(const std::string &path);
+
+  // unmap the file
+  void close();
+
+  // return true if a file is mapped
+  bool is_open() const;
+
+  // the bytes of the file
+  const char *data() const;
+  size_t size() const;
+  std::string_view view() const;
+
+private:
+  const char *_data;
+  size_t _size;
+  bool _open;
+
+  // a mapping cannot be shared
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+};
+
+#endif
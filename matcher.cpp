@@ -0,0 +1,25 @@
+// File: matcher.cpp
+// Purpose: Abstract class for an engine which runs a compiled program.
+// Author: Robert Lowe
+#include "matcher.h"
+
+// construct a matcher
+Matcher::Matcher() : _examined(0) {}
+
+// virtual destructor
+Matcher::~Matcher() {
+  // This space left intentionally blank.
+}
+
+// By default, search by trying an anchored match at every position.
+bool Matcher::search(std::string_view str, size_t pos, size_t &start,
+                     size_t &end) {
+  for (; pos <= str.length(); pos++) {
+    if (match(str, pos, end)) {
+      start = pos;
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,54 @@
+// File: matcher.h
+// Purpose: Abstract class for an engine which runs a compiled program.
+// Author: Robert Lowe
+#ifndef MATCHER_H
+#define MATCHER_H
+#include <string_view>
+
+// The part of a string a match or one of its capture groups covers,
+// start..end. A group which took no part in the match is npos..npos.
+struct Span {
+  size_t start;
+  size_t end;
+};
+
+class Matcher {
+public:
+  // construct a matcher
+  Matcher();
+
+  // virtual destructor
+  virtual ~Matcher();
+
+  // Attempt an anchored match of the string beginning at the given position.
+  // Parameters:
+  //   str - The string to match
+  //   pos - The position in the string to match
+  //   end - Receives the position after the longest match
+  // Returns:
+  //   true if some prefix of the string beginning at pos matches
+  //   false otherwise, in which case end is left alone
+  virtual bool match(std::string_view str, size_t pos, size_t &end) = 0;
+
+  // Attempt an anchored match, also reporting the smallest match id among
+  // the program's match instructions accepting the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end,
+                     int &id) = 0;
+
+  // Search for the leftmost match beginning at or after pos. Among the
+  // matches beginning there, the longest is reported as start..end.
+  // The default tries an anchored match at every position in turn.
+  virtual bool search(std::string_view str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // One past the last position the most recent anchored match looked at.
+  // Reaching the end of the input counts as looking at position length, so
+  // a match which ran into the end reports length + 1. Bytes from here on
+  // cannot have changed the match.
+  size_t examined() const { return _examined; }
+
+protected:
+  size_t _examined;
+};
+
+#endif
@@ -0,0 +1,163 @@
+// File: nfa_compiler.cpp
+// Purpose: Lower a tree of RegexNodes into a Thompson NFA program.
+// Author: Robert Lowe
+#include "nfa_compiler.h"
+
+// construct a compiler
+NfaCompiler::NfaCompiler() : _program(nullptr) {}
+
+// Compile the tree rooted at root into a new program which the caller owns.
+Program *NfaCompiler::compile(RegexNode *root) {
+  _program = new Program();
+  _fragments.clear();
+
+  if (!compile_node(root)) {
+    delete _program;
+    _program = nullptr;
+    return nullptr;
+  }
+  emit_match(0);
+  _program->compute_alphabet();
+
+  Program *result = _program;
+  _program = nullptr;
+  return result;
+}
+
+// Compile several trees into one program which matches any of them:
+//       split L1, L2
+//   L1: <root 1>
+//       match 0
+//   L2: split L3, L4
+//       ...
+//   Ln: <root n>
+//       match n-1
+Program *NfaCompiler::compile(const std::vector<RegexNode *> &roots) {
+  _program = new Program();
+  _fragments.clear();
+
+  for (size_t i = 0; i < roots.size(); i++) {
+    int split = -1;
+    if (i + 1 < roots.size()) {
+      split = emit_split(pc() + 1, -1);
+    }
+    if (!compile_node(roots[i])) {
+      delete _program;
+      _program = nullptr;
+      return nullptr;
+    }
+    emit_match(i);
+    if (split >= 0) {
+      patch_y(split, pc());
+    }
+  }
+
+  // with no roots at all, match nothing
+  if (roots.empty()) {
+    emit_set(ByteSet());
+  }
+  _program->compute_alphabet();
+
+  Program *result = _program;
+  _program = nullptr;
+  return result;
+}
+
+// Compile one node into the program under construction.
+bool NfaCompiler::compile_node(RegexNode *node) {
+  if (!node) {
+    return false;
+  }
+
+  // anything which consumes exactly one byte becomes a single instruction
+  ByteSet set;
+  if (node->byte_set(set)) {
+    emit_set(set);
+    return true;
+  }
+
+  if (node->references() == 1) {
+    return node->compile(*this);
+  }
+
+  // a shared node is compiled where it first occurs, and copied after that
+  auto found = _fragments.find(node);
+  if (found != _fragments.end()) {
+    copy(found->second.first, found->second.second);
+    return true;
+  }
+
+  int start = pc();
+  if (!node->compile(*this)) {
+    return false;
+  }
+  _fragments[node] = std::make_pair(start, pc());
+  return true;
+}
+
+int NfaCompiler::emit_char(unsigned char c) {
+  int pc = _program->emit(Instruction::CHAR);
+  (*_program)[pc].lo = c;
+  (*_program)[pc].hi = c;
+  return pc;
+}
+
+int NfaCompiler::emit_range(unsigned char lo, unsigned char hi) {
+  int pc = _program->emit(Instruction::RANGE);
+  (*_program)[pc].lo = lo;
+  (*_program)[pc].hi = hi;
+  return pc;
+}
+
+// emit the cheapest instruction which consumes a byte from set
+int NfaCompiler::emit_set(const ByteSet &set) {
+  unsigned char lo, hi;
+
+  if (set.full()) {
+    return _program->emit(Instruction::ANY);
+  } else if (set.single_range(lo, hi)) {
+    return lo == hi ? emit_char(lo) : emit_range(lo, hi);
+  }
+
+  return _program->emit(Instruction::CLASS, _program->add_class(set));
+}
+
+int NfaCompiler::emit_split(int x, int y) {
+  return _program->emit(Instruction::SPLIT, x, y);
+}
+
+int NfaCompiler::emit_jmp(int x) { return _program->emit(Instruction::JMP, x); }
+
+int NfaCompiler::emit_save(int slot) {
+  return _program->emit(Instruction::SAVE, slot);
+}
+
+int NfaCompiler::emit_match(int id) {
+  return _program->emit(Instruction::MATCH, id);
+}
+
+// Patch the jump targets of a previously emitted instruction
+void NfaCompiler::patch_x(int pc, int target) { (*_program)[pc].x = target; }
+void NfaCompiler::patch_y(int pc, int target) { (*_program)[pc].y = target; }
+
+// Emit a copy of the instructions start..end. Their jumps all lead within
+// start..end, so each moves along with the copy.
+void NfaCompiler::copy(int start, int end) {
+  int offset = pc() - start;
+
+  for (int i = start; i < end; i++) {
+    Instruction inst = (*_program)[i];
+    if (inst.op == Instruction::SPLIT || inst.op == Instruction::JMP) {
+      inst.x += offset;
+    }
+    if (inst.op == Instruction::SPLIT) {
+      inst.y += offset;
+    }
+    int copied = _program->emit(inst.op, inst.x, inst.y);
+    (*_program)[copied].lo = inst.lo;
+    (*_program)[copied].hi = inst.hi;
+  }
+}
+
+// the address of the next instruction to be emitted
+int NfaCompiler::pc() const { return _program->size(); }
@@ -0,0 +1,61 @@
+// File: nfa_compiler.h
+// Purpose: Lower a tree of RegexNodes into a Thompson NFA program.
+// Author: Robert Lowe
+#ifndef NFA_COMPILER_H
+#define NFA_COMPILER_H
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "byte_set.h"
+#include "program.h"
+#include "regex_node.h"
+
+class NfaCompiler {
+public:
+  // construct a compiler
+  NfaCompiler();
+
+  // Compile the tree rooted at root into a new program which the caller
+  // owns. Returns nullptr if some node in the tree cannot be compiled.
+  Program *compile(RegexNode *root);
+
+  // Compile several trees into one program which matches any of them. The
+  // match instruction of roots[i] has id i. Returns nullptr if some node
+  // cannot be compiled.
+  Program *compile(const std::vector<RegexNode *> &roots);
+
+  // Compile one node into the program under construction. Nodes call this
+  // to compile their children. A node shared by several parents is
+  // compiled once, and its instructions are copied where it recurs.
+  // Returns false if the node cannot be compiled.
+  bool compile_node(RegexNode *node);
+
+  // Emit instructions, returning the address of the new instruction.
+  // Jump targets which are not known yet may be given as -1 and patched
+  // later.
+  int emit_char(unsigned char c);
+  int emit_range(unsigned char lo, unsigned char hi);
+  int emit_set(const ByteSet &set);
+  int emit_split(int x, int y);
+  int emit_jmp(int x);
+  int emit_save(int slot);
+  int emit_match(int id);
+
+  // Patch the jump targets of a previously emitted instruction
+  void patch_x(int pc, int target);
+  void patch_y(int pc, int target);
+
+  // the address of the next instruction to be emitted
+  int pc() const;
+
+private:
+  Program *_program;
+
+  // the instructions first emitted for each shared node, start..end
+  std::unordered_map<RegexNode *, std::pair<int, int>> _fragments;
+
+  // emit a copy of the instructions start..end, moving their jumps along
+  void copy(int start, int end);
+};
+
+#endif
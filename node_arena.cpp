@@ -0,0 +1,52 @@
+// File: node_arena.cpp
+// Purpose: An arena for the nodes of regex trees.
+// Author: Robert Lowe
+#include "node_arena.h"
+
+// the arena in scope on each thread
+static thread_local NodeArena *current_arena = nullptr;
+
+// construct an empty arena
+NodeArena::NodeArena(size_t block_size)
+    : _buffer(block_size, std::pmr::new_delete_resource()), _used(0) {}
+
+// release the arena and every node in it
+NodeArena::~NodeArena() {
+  // the monotonic buffer frees its blocks when it is destroyed
+}
+
+// release every node in the arena at once
+void NodeArena::release() {
+  _buffer.release();
+  _used = 0;
+}
+
+// place the nodes created on this thread in the arena
+NodeArena::Scope::Scope(NodeArena *arena) : _previous(current_arena) {
+  if (arena) {
+    current_arena = arena;
+  }
+}
+
+// go back to the arena which was in scope before
+NodeArena::Scope::~Scope() { current_arena = _previous; }
+
+// the arena in scope on this thread
+NodeArena *NodeArena::current() { return current_arena; }
+
+// the memory resource for node storage
+std::pmr::memory_resource *NodeArena::resource() {
+  if (current_arena) {
+    return &current_arena->_buffer;
+  }
+  return std::pmr::get_default_resource();
+}
+
+// allocate bytes from the arena
+void *NodeArena::allocate(size_t bytes) {
+  _used += bytes;
+  return _buffer.allocate(bytes, alignof(std::max_align_t));
+}
+
+// the bytes of the nodes placed in the arena
+size_t NodeArena::used() const { return _used; }
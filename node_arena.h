@@ -0,0 +1,58 @@
+// File: node_arena.h
+// Purpose: An arena for the nodes of regex trees. While an arena is in
+//          scope, every RegexNode created on the thread is placed in it,
+//          one after another, instead of being allocated separately. The
+//          whole arena is released at once.
+// Author: Robert Lowe
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+#include <cstddef>
+#include <memory_resource>
+
+class NodeArena {
+public:
+  // construct an empty arena which grows in blocks of at least block_size
+  NodeArena(size_t block_size = 4096);
+
+  // release the arena and every node in it
+  virtual ~NodeArena();
+
+  // Release every node in the arena at once, without running destructors.
+  // Trees in the arena must not be used or deleted afterwards.
+  void release();
+
+  // Place the nodes created on this thread in an arena for the lifetime of
+  // the scope. Scopes may be nested, and a null arena leaves the arena of
+  // the enclosing scope in place.
+  class Scope {
+  public:
+    Scope(NodeArena *arena);
+    ~Scope();
+
+  private:
+    NodeArena *_previous;
+  };
+
+  // the arena in scope on this thread, or nullptr
+  static NodeArena *current();
+
+  // The memory resource for node storage: the arena in scope, or the
+  // default resource when there is none.
+  static std::pmr::memory_resource *resource();
+
+  // allocate bytes from the arena
+  void *allocate(size_t bytes);
+
+  // the bytes of the nodes placed in the arena
+  size_t used() const;
+
+private:
+  std::pmr::monotonic_buffer_resource _buffer;
+  size_t _used;
+
+  // an arena cannot be shared
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+};
+
+#endif
@@ -0,0 +1,145 @@
+// File: node_builder.cpp
+// Purpose: Share the structurally identical subtrees of regex trees, so
+//          that they form a DAG in which each distinct subtree is built
+//          once.
+// Author: Robert Lowe
+#include "node_builder.h"
+#include "literal_node.h"
+#include "regex.h"
+
+// construct a builder which holds no nodes
+NodeBuilder::NodeBuilder() {}
+
+// drop the builder's references to its nodes
+NodeBuilder::~NodeBuilder() { clear(); }
+
+// Share the identical subtrees of the tree rooted at root
+RegexNode *NodeBuilder::intern(RegexNode *root) {
+  if (!root) {
+    return nullptr;
+  }
+
+  return rebuild(root);
+}
+
+// Share the node with every identical node the builder has seen. The node
+// is dropped in favor of the one seen first.
+RegexNode *NodeBuilder::share(RegexNode *node) {
+  Key key;
+
+  if (!node) {
+    return nullptr;
+  }
+
+  node = rebuild(node);
+  if (!make_key(node, key)) {
+    return node;
+  }
+
+  auto found = _nodes.find(key);
+  if (found != _nodes.end()) {
+    RegexNode::unref(node);
+    return found->second->ref();
+  }
+
+  // the builder holds a reference of its own
+  _nodes.emplace(std::move(key), node->ref());
+  return node;
+}
+
+// the number of distinct nodes the builder holds
+size_t NodeBuilder::size() const { return _nodes.size(); }
+
+// drop every node the builder holds
+void NodeBuilder::clear() {
+  for (auto &entry : _nodes) {
+    RegexNode::unref(entry.second);
+  }
+  _nodes.clear();
+}
+
+// Replace the children of the node with their shared copies. A node which
+// is shared already is left alone, as its other owners may rely on it.
+RegexNode *NodeBuilder::rebuild(RegexNode *node) {
+  if (node->references() > 1) {
+    return node;
+  }
+
+  if (GroupNode *group = dynamic_cast<GroupNode *>(node)) {
+    std::vector<RegexNode *> nodes(group->nodes().begin(),
+                                   group->nodes().end());
+    group->release_nodes();
+    for (auto child : nodes) {
+      group->add_node(share(child));
+    }
+    return group;
+  }
+
+  if (OrNode *alt = dynamic_cast<OrNode *>(node)) {
+    std::vector<RegexNode *> nodes(alt->nodes().begin(), alt->nodes().end());
+    alt->release_nodes();
+    for (auto child : nodes) {
+      alt->add_node(share(child));
+    }
+    return alt;
+  }
+
+  // quantifiers are built anew around their shared node
+  RegexNode *result = node;
+  if (ZeroNode *zero = dynamic_cast<ZeroNode *>(node)) {
+    result = new ZeroNode(share(zero->release()));
+  } else if (OneNode *one = dynamic_cast<OneNode *>(node)) {
+    result = new OneNode(share(one->release()));
+  } else if (OptionalNode *opt = dynamic_cast<OptionalNode *>(node)) {
+    result = new OptionalNode(share(opt->release()));
+  } else if (CaptureNode *capture = dynamic_cast<CaptureNode *>(node)) {
+    int index = capture->index();
+    result = new CaptureNode(index, share(capture->release()));
+  }
+  if (result != node) {
+    delete node;
+  }
+
+  return result;
+}
+
+// Make the key of a rebuilt node. Inner nodes are known by their children,
+// and leaves by their literal or their byte set.
+bool NodeBuilder::make_key(RegexNode *node, Key &key) {
+  key.type = &typeid(*node);
+
+  if (GroupNode *group = dynamic_cast<GroupNode *>(node)) {
+    key.children.assign(group->nodes().begin(), group->nodes().end());
+  } else if (OrNode *alt = dynamic_cast<OrNode *>(node)) {
+    key.children.assign(alt->nodes().begin(), alt->nodes().end());
+  } else if (ZeroNode *zero = dynamic_cast<ZeroNode *>(node)) {
+    key.children.push_back(zero->node());
+  } else if (OneNode *one = dynamic_cast<OneNode *>(node)) {
+    key.children.push_back(one->node());
+  } else if (OptionalNode *opt = dynamic_cast<OptionalNode *>(node)) {
+    key.children.push_back(opt->node());
+  } else if (CaptureNode *capture = dynamic_cast<CaptureNode *>(node)) {
+    key.text = std::to_string(capture->index());
+    key.children.push_back(capture->node());
+  } else if (LiteralNode *literal = dynamic_cast<LiteralNode *>(node)) {
+    key.text = literal->text();
+  } else if (!node->byte_set(key.set)) {
+    return false;
+  }
+
+  return true;
+}
+
+bool NodeBuilder::Key::operator==(const Key &other) const {
+  return *type == *other.type && set == other.set && text == other.text &&
+         children == other.children;
+}
+
+size_t NodeBuilder::KeyHash::operator()(const Key &key) const {
+  size_t result = key.type->hash_code() ^ key.set.hash() ^
+                  std::hash<std::string>()(key.text);
+  for (auto child : key.children) {
+    result = (result ^ (size_t)child) * 0x9E3779B97F4A7C15ull;
+  }
+  return result;
+}
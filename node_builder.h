@@ -0,0 +1,74 @@
+// File: node_builder.h
+// Purpose: Share the structurally identical subtrees of regex trees, so
+//          that they form a DAG in which each distinct subtree is built
+//          once.
+// Author: Robert Lowe
+#ifndef NODE_BUILDER_H
+#define NODE_BUILDER_H
+#include <cstddef>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include "byte_set.h"
+#include "regex_node.h"
+
+class NodeBuilder {
+public:
+  // construct a builder which holds no nodes
+  NodeBuilder();
+
+  // drop the builder's references to its nodes
+  ~NodeBuilder();
+
+  // Share the identical subtrees of the tree rooted at root, which the
+  // builder takes over, and return the root of the result. The root itself
+  // is not shared, so its owner may still delete it. Subtrees the builder
+  // does not know how to compare are kept as they are. The builder holds a
+  // reference to each distinct subtree until clear(), so one kept across
+  // many trees grows with all of them.
+  RegexNode *intern(RegexNode *root);
+
+  // Like intern, but the root is shared as well. The caller holds one
+  // reference to the result, and must drop it with RegexNode::unref.
+  RegexNode *share(RegexNode *node);
+
+  // the number of distinct nodes the builder holds
+  size_t size() const;
+
+  // drop every node the builder holds
+  void clear();
+
+private:
+  // What makes two nodes identical: their class, the bytes a leaf
+  // matches, and the children of an inner node, which are shared already
+  // so that they can be compared by address.
+  struct Key {
+    const std::type_info *type;
+    ByteSet set;
+    std::string text;
+    std::vector<RegexNode *> children;
+
+    bool operator==(const Key &other) const;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key &key) const;
+  };
+
+  std::unordered_map<Key, RegexNode *, KeyHash> _nodes;
+
+  // Replace the children of the node with their shared copies, returning
+  // the node or its replacement.
+  RegexNode *rebuild(RegexNode *node);
+
+  // Make the key of a rebuilt node, returning false if the builder does
+  // not know how to compare it.
+  bool make_key(RegexNode *node, Key &key);
+
+  // the builder holds references, so it cannot be copied
+  NodeBuilder(const NodeBuilder &) = delete;
+  NodeBuilder &operator=(const NodeBuilder &) = delete;
+};
+
+#endif
@@ -2,19 +2,32 @@
 // Purpose: The one node matches the one or more quantifier.
 // Author: Robert Lowe
 #include "one_node.h"
+#include "class_node.h"
+#include "nfa_compiler.h"
 #include <string>
 
 // Construct a one node with the node to repeat
-OneNode::OneNode(RegexNode *node) { this->_node = node; }
+OneNode::OneNode(RegexNode *node) {
+  this->_node = node;
+  this->_class = dynamic_cast<ClassNode *>(node);
+}
 
 // Destruct a one node
-OneNode::~OneNode() { delete _node; }
+OneNode::~OneNode() { RegexNode::unref(_node); }
 
 // Attempt to match the string beginning at the given position.
 bool OneNode::match(const std::string &str, size_t &pos) {
   // Save the original position
   size_t originalPos = pos;
 
+  // a class can skip the whole run at once
+  if (_class) {
+    if (pos < str.length()) {
+      pos += _class->span(str.data() + pos, str.length() - pos);
+    }
+    return pos > originalPos;
+  }
+
   // Attempt to match the node at least once
   if (!_node->match(str, pos)) {
     // If the node doesn't match at least once, return false
@@ -29,3 +42,30 @@ bool OneNode::match(const std::string &str, size_t &pos) {
   // If we managed to match the node at least once, return true
   return pos > originalPos;
 }
+
+// Compile one or more repetitions:
+//   L1: <node>
+//       split L1, end
+//  end:
+bool OneNode::compile(NfaCompiler &compiler) {
+  int start = compiler.pc();
+  if (!compiler.compile_node(_node)) {
+    return false;
+  }
+  compiler.emit_split(start, compiler.pc() + 1);
+  return true;
+}
+
+// One or more repetitions begin like the node.
+bool OneNode::first_bytes(ByteSet &set) { return _node->first_bytes(set); }
+
+// retrieve the node to repeat
+RegexNode *OneNode::node() const { return _node; }
+
+// give up the node without deleting it
+RegexNode *OneNode::release() {
+  RegexNode *result = _node;
+  _node = nullptr;
+  _class = nullptr;
+  return result;
+}
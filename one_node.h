@@ -6,6 +6,8 @@
 #include <string>
 #include "regex_node.h"
 
+class ClassNode;
+
 class OneNode : public RegexNode {
 public:
   // construct a zero node with the node to repeat
@@ -17,8 +19,23 @@ public:
   // Attempt to match the string beginning at the given position.
   virtual bool match(const std::string &str, size_t &pos);
 
+  // compile the quantifier around its node
+  virtual bool compile(NfaCompiler &compiler);
+
+  // the bytes which can begin a match, and whether it may be empty
+  virtual bool first_bytes(ByteSet &set);
+
+  // retrieve the node to repeat
+  RegexNode *node() const;
+
+  // give up the node without deleting it, returning it
+  RegexNode *release();
+
 private:
   // the node to repeat
   RegexNode *_node;
+
+  // the node to repeat, if it is a class which can skip whole runs
+  ClassNode *_class;
 };
 #endif
\ No newline at end of file
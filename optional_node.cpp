@@ -2,10 +2,11 @@
 // Purpose: The optional node quantifier
 // Author: Robert Lowe
 #include "optional_node.h"
+#include "nfa_compiler.h"
 
 OptionalNode::OptionalNode(RegexNode *node) { this->_node = node; }
 
-OptionalNode::~OptionalNode() { delete this->_node; }
+OptionalNode::~OptionalNode() { RegexNode::unref(_node); }
 
 // Attempt to match the string at position pos
 bool OptionalNode::match(const std::string &str, size_t &pos) {
@@ -18,3 +19,32 @@ bool OptionalNode::match(const std::string &str, size_t &pos) {
   // Always return true, even if no match occurred, because it's optional
   return true;
 }
+
+// Compile zero or one occurrence:
+//       split L1, end
+//   L1: <node>
+//  end:
+bool OptionalNode::compile(NfaCompiler &compiler) {
+  int split = compiler.emit_split(compiler.pc() + 1, -1);
+  if (!compiler.compile_node(_node)) {
+    return false;
+  }
+  compiler.patch_y(split, compiler.pc());
+  return true;
+}
+
+// An optional node begins like its node, and may be empty.
+bool OptionalNode::first_bytes(ByteSet &set) {
+  _node->first_bytes(set);
+  return true;
+}
+
+// retrieve the node which is optional
+RegexNode *OptionalNode::node() const { return _node; }
+
+// give up the node without deleting it
+RegexNode *OptionalNode::release() {
+  RegexNode *result = _node;
+  _node = nullptr;
+  return result;
+}
@@ -13,6 +13,18 @@ public:
   // attempt to match the string at position pos
   virtual bool match(const std::string& str, size_t &pos);
 
+  // compile the quantifier around its node
+  virtual bool compile(NfaCompiler &compiler);
+
+  // the bytes which can begin a match, and whether it may be empty
+  virtual bool first_bytes(ByteSet &set);
+
+  // retrieve the node which is optional
+  RegexNode *node() const;
+
+  // give up the node without deleting it, returning it
+  RegexNode *release();
+
 private:
   RegexNode* _node;
 };
@@ -2,13 +2,19 @@
 // Purpose: Implements a multi-way or operator.
 // Author: Robert Lowe
 #include "or_node.h"
+#include "byte_set.h"
+#include "nfa_compiler.h"
+#include "node_arena.h"
 #include <iostream>
 #include <string>
 #include <vector>
 
+// construct an empty or, stored in the node arena in scope if any
+OrNode::OrNode() : _nodes(NodeArena::resource()) {}
+
 OrNode::~OrNode() {
   for (auto node : _nodes) {
-    delete node;
+    RegexNode::unref(node);
   }
 }
 
@@ -37,3 +43,81 @@ bool OrNode::match(const std::string &str, size_t &pos) {
 
 // Add a node to the or
 void OrNode::add_node(RegexNode *node) { this->_nodes.push_back(node); }
+
+// retrieve the alternatives
+const std::pmr::vector<RegexNode *> &OrNode::nodes() const { return _nodes; }
+
+// give up the nodes without deleting them
+void OrNode::release_nodes() { _nodes.clear(); }
+
+// An or of single byte nodes matches the union of their sets
+bool OrNode::byte_set(ByteSet &set) {
+  ByteSet result;
+
+  if (_nodes.empty()) {
+    return false;
+  }
+
+  for (auto node : _nodes) {
+    if (!node || !node->byte_set(result)) {
+      return false;
+    }
+  }
+
+  set.merge(result);
+  return true;
+}
+
+// An or begins with any of its alternatives.
+bool OrNode::first_bytes(ByteSet &set) {
+  bool nullable = false;
+
+  for (auto node : _nodes) {
+    if (!node) {
+      set.fill();
+      return true;
+    }
+    if (node->first_bytes(set)) {
+      nullable = true;
+    }
+  }
+
+  return nullable;
+}
+
+// Compile the or as a chain of splits, one for each alternative:
+//       split L1, L2
+//   L1: <node 1>
+//       jmp end
+//   L2: split L3, L4
+//       ...
+//   Ln: <node n>
+//  end:
+bool OrNode::compile(NfaCompiler &compiler) {
+  std::vector<int> jumps;
+
+  // an empty or never matches
+  if (_nodes.empty()) {
+    compiler.emit_set(ByteSet());
+    return true;
+  }
+
+  for (size_t i = 0; i + 1 < _nodes.size(); i++) {
+    int split = compiler.emit_split(compiler.pc() + 1, -1);
+    if (!compiler.compile_node(_nodes[i])) {
+      return false;
+    }
+    jumps.push_back(compiler.emit_jmp(-1));
+    compiler.patch_y(split, compiler.pc());
+  }
+  if (!compiler.compile_node(_nodes.back())) {
+    return false;
+  }
+
+  // all the alternatives meet at the end
+  for (auto jump : jumps) {
+    compiler.patch_x(jump, compiler.pc());
+  }
+
+  return true;
+}
@@ -4,11 +4,15 @@
 #ifndef OR_NODE_H
 #define OR_NODE_H
 #include <string>
+#include <memory_resource>
 #include <vector>
 #include "regex_node.h"
 
 class OrNode : public RegexNode {
 public:
+  // construct an empty or, stored in the node arena in scope if any
+  OrNode();
+
   ~OrNode();
 
   // perform a greedy or match on the given string starting at pos
@@ -17,8 +21,23 @@ public:
   // add a node to the or
   virtual void add_node(RegexNode *node);
 
+  // retrieve the alternatives
+  const std::pmr::vector<RegexNode *> &nodes() const;
+
+  // give up the nodes without deleting them, leaving no nodes
+  void release_nodes();
+
+  // an or of single byte nodes matches the union of their sets
+  virtual bool byte_set(ByteSet &set);
+
+  // the bytes which can begin a match, and whether it may be empty
+  virtual bool first_bytes(ByteSet &set);
+
+  // compile the or as a chain of splits
+  virtual bool compile(NfaCompiler &compiler);
+
 private:
-  std::vector<RegexNode *> _nodes;
+  std::pmr::vector<RegexNode *> _nodes;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+// File: parallel_lexer.cpp
+// Purpose: Lex a large input on several threads. The input is split into
+//          chunks at synchronization points, where no token can cross, and
+//          each chunk is lexed by its own lexer. The token streams are then
+//          merged in order.
+// Author: Robert Lowe
+#include "parallel_lexer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+// remove all the tokens
+void ParallelLexer::Tokens::clear() {
+  tok.clear();
+  pos.clear();
+  len.clear();
+}
+
+// Construct a parallel lexer which uses the given number of threads
+ParallelLexer::ParallelLexer(TokenSetup setup, unsigned threads)
+    : _setup(setup), _threads(threads), _min_chunk(64 * 1024),
+      _verify(false) {
+  if (_threads == 0) {
+    _threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+// split the input where sync returns true instead of after newlines
+void ParallelLexer::sync_point(SyncPoint sync) { _sync = sync; }
+
+// the smallest chunk worth giving to a thread
+void ParallelLexer::min_chunk(size_t bytes) {
+  _min_chunk = std::max<size_t>(bytes, 1);
+}
+
+// check the parallel result against a sequential run
+void ParallelLexer::verify(bool verify) { _verify = verify; }
+
+// the number of threads used
+unsigned ParallelLexer::threads() const { return _threads; }
+
+// Lex the whole input into result
+bool ParallelLexer::lex(std::string_view input, Tokens &result) {
+  std::vector<size_t> bounds = split(input);
+  size_t chunks = bounds.size() - 1;
+
+  // with nothing to share out, skip the merge and its copying
+  if (_threads == 1 || chunks == 1) {
+    lex_sequential(input, result);
+    return true;
+  }
+
+  std::vector<Tokens> pieces(chunks);
+  std::atomic<size_t> next_chunk(0);
+
+  // each thread lexes whichever chunk is next until none are left
+  auto worker = [&]() {
+    Lexer lexer;
+    _setup(lexer);
+    for (size_t i; (i = next_chunk++) < chunks;) {
+      lex_chunk(lexer,
+                input.substr(bounds[i], bounds[i + 1] - bounds[i]),
+                bounds[i], pieces[i]);
+    }
+  };
+
+  unsigned count = std::min<size_t>(_threads, chunks);
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < count; i++) {
+    pool.push_back(std::thread(worker));
+  }
+  worker();
+  for (auto &thread : pool) {
+    thread.join();
+  }
+
+  // merge the pieces in order
+  size_t total = 0;
+  for (auto &piece : pieces) {
+    total += piece.size();
+  }
+  result.clear();
+  result.tok.reserve(total);
+  result.pos.reserve(total);
+  result.len.reserve(total);
+  for (auto &piece : pieces) {
+    result.tok.insert(result.tok.end(), piece.tok.begin(), piece.tok.end());
+    result.pos.insert(result.pos.end(), piece.pos.begin(), piece.pos.end());
+    result.len.insert(result.len.end(), piece.len.begin(), piece.len.end());
+  }
+
+  if (_verify) {
+    Tokens expected;
+    lex_sequential(input, expected);
+    return expected.tok == result.tok && expected.pos == result.pos &&
+           expected.len == result.len;
+  }
+
+  return true;
+}
+
+// lex the whole input on this thread only
+void ParallelLexer::lex_sequential(std::string_view input, Tokens &result) {
+  Lexer lexer;
+
+  _setup(lexer);
+  result.clear();
+  lex_chunk(lexer, input, 0, result);
+}
+
+// Split the input into about four chunks per thread, so that threads which
+// finish early can take over the work of slow ones. Each chunk ends at the
+// first sync point after its share of the input.
+std::vector<size_t> ParallelLexer::split(std::string_view input) const {
+  std::vector<size_t> bounds;
+  size_t size = input.length();
+  size_t chunk = std::max(_min_chunk, size / (4 * _threads) + 1);
+
+  bounds.push_back(0);
+  for (size_t pos = chunk; pos < size;) {
+    // find a sync point at or after pos
+    if (_sync) {
+      while (pos < size && !_sync(input, pos)) {
+        pos++;
+      }
+    } else {
+      const void *nl = memchr(input.data() + pos - 1, '\n', size - pos + 1);
+      pos = nl ? (const char *)nl - input.data() + 1 : size;
+    }
+    if (pos >= size) {
+      break;
+    }
+
+    bounds.push_back(pos);
+    pos += chunk;
+  }
+  bounds.push_back(size);
+
+  return bounds;
+}
+
+// lex one piece of the input, offsetting the positions by base
+void ParallelLexer::lex_chunk(Lexer &lexer, std::string_view chunk,
+                              size_t base, Tokens &result) {
+  const size_t BATCH = 1024;
+  int tok[BATCH];
+  size_t pos[BATCH], len[BATCH];
+  size_t count;
+
+  if (!lexer.borrow(chunk)) {
+    // tree patterns can only lex a copy
+    lexer.input(std::string(chunk));
+  }
+  while ((count = lexer.next_batch(tok, pos, len, BATCH)) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      pos[i] += base;
+    }
+    result.tok.insert(result.tok.end(), tok, tok + count);
+    result.pos.insert(result.pos.end(), pos, pos + count);
+    result.len.insert(result.len.end(), len, len + count);
+  }
+}
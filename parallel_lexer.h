@@ -0,0 +1,78 @@
+// File: parallel_lexer.h
+// Purpose: Lex a large input on several threads. The input is split into
+//          chunks at synchronization points, where no token can cross, and
+//          each chunk is lexed by its own lexer. The token streams are then
+//          merged in order.
+// Author: Robert Lowe
+#ifndef PARALLEL_LEXER_H
+#define PARALLEL_LEXER_H
+#include <functional>
+#include <string_view>
+#include <vector>
+#include "lexer.h"
+
+class ParallelLexer {
+public:
+  // Adds the token patterns to a lexer. Each thread builds its own lexer
+  // with it, so the patterns must be the same every time.
+  typedef std::function<void(Lexer &)> TokenSetup;
+
+  // Return true if a token always begins at pos, so the input may be split
+  // there. pos is never 0 or the end of the input.
+  typedef std::function<bool(std::string_view input, size_t pos)> SyncPoint;
+
+  // The tokens of the input, stored as parallel arrays like
+  // Lexer::next_batch. The end-of-input token is not stored.
+  struct Tokens {
+    std::vector<int> tok;
+    std::vector<size_t> pos;
+    std::vector<size_t> len;
+
+    // the number of tokens
+    size_t size() const { return tok.size(); }
+
+    // remove all the tokens
+    void clear();
+  };
+
+  // Construct a parallel lexer which uses the given number of threads, or
+  // one per core if threads is 0. The input is split after newlines.
+  ParallelLexer(TokenSetup setup, unsigned threads = 0);
+
+  // split the input where sync returns true instead of after newlines
+  void sync_point(SyncPoint sync);
+
+  // the smallest chunk worth giving to a thread
+  void min_chunk(size_t bytes);
+
+  // When verify is set, each lex is repeated on one thread and the results
+  // compared, so that sync points which a token can cross are caught.
+  void verify(bool verify);
+
+  // Lex the whole input into result. Returns false if verification is on
+  // and the parallel tokens differ from the sequential ones.
+  bool lex(std::string_view input, Tokens &result);
+
+  // lex the whole input on this thread only
+  void lex_sequential(std::string_view input, Tokens &result);
+
+  // the number of threads used
+  unsigned threads() const;
+
+private:
+  TokenSetup _setup;
+  SyncPoint _sync;
+  unsigned _threads;
+  size_t _min_chunk;
+  bool _verify;
+
+  // split the input into chunks, returning the start of each chunk followed
+  // by the end of the input
+  std::vector<size_t> split(std::string_view input) const;
+
+  // lex one piece of the input, offsetting the positions by base
+  static void lex_chunk(Lexer &lexer, std::string_view chunk, size_t base,
+                        Tokens &result);
+};
+
+#endif
@@ -0,0 +1,195 @@
+// File: pike_vm.cpp
+// Purpose: Run a compiled program by simulating its NFA one input byte at a
+//          time.
+// Author: Robert Lowe
+#include "pike_vm.h"
+#include <algorithm>
+#include <utility>
+
+//////////////////////////////////////////
+// PikeVM Methods
+//////////////////////////////////////////
+
+// construct a vm to run the program
+PikeVM::PikeVM(const Program *program)
+    : _program(program), _clist(program->size()), _nlist(program->size()),
+      _cstart(program->size()), _nstart(program->size()) {}
+
+// Attempt an anchored match of the string beginning at pos
+bool PikeVM::match(std::string_view str, size_t pos, size_t &end) {
+  int id;
+  return match(str, pos, end, id);
+}
+
+// Attempt an anchored match, also reporting the match id
+bool PikeVM::match(std::string_view str, size_t pos, size_t &end, int &id) {
+  bool matched = false;
+
+  _clist.clear();
+  add_thread(_clist, _cstart, _program->start(), pos);
+
+  // the threads look at each position they reach, the end included
+  _examined = pos;
+  for (size_t p = pos; !_clist.empty(); p++) {
+    _nlist.clear();
+    _examined = p + 1;
+
+    for (unsigned i = 0; i < _clist.size(); i++) {
+      int pc = _clist[i];
+      const Instruction &inst = (*_program)[pc];
+
+      if (inst.op == Instruction::MATCH) {
+        // keep running, a longer match may follow
+        if (!matched || end != p || inst.x < id) {
+          id = inst.x;
+        }
+        matched = true;
+        end = p;
+      } else if (p < str.length() && _program->consumes(pc, str[p])) {
+        add_thread(_nlist, _nstart, pc + 1, pos);
+      }
+    }
+
+    std::swap(_clist, _nlist);
+    std::swap(_cstart, _nstart);
+  }
+
+  return matched;
+}
+
+// Search for the leftmost-longest match in one pass over the string.
+bool PikeVM::search(std::string_view str, size_t pos, size_t &start,
+                    size_t &end) {
+  bool matched = false;
+
+  _clist.clear();
+  for (size_t p = pos; p <= str.length(); p++) {
+    // threads beginning here have the lowest priority, and are not needed
+    // once something to the left has matched
+    if (!matched) {
+      add_thread(_clist, _cstart, _program->start(), p);
+    } else if (_clist.empty()) {
+      break;
+    }
+
+    _nlist.clear();
+    for (unsigned i = 0; i < _clist.size(); i++) {
+      int pc = _clist[i];
+      size_t s = _cstart[pc];
+
+      // a thread to the right of a match can never win
+      if (matched && s > start) {
+        continue;
+      }
+
+      if ((*_program)[pc].op == Instruction::MATCH) {
+        if (!matched || s < start || (s == start && p > end)) {
+          start = s;
+          end = p;
+        }
+        matched = true;
+      } else if (p < str.length() && _program->consumes(pc, str[p])) {
+        add_thread(_nlist, _nstart, pc + 1, s);
+      }
+    }
+
+    std::swap(_clist, _nlist);
+    std::swap(_cstart, _nstart);
+  }
+
+  return matched;
+}
+
+// Attempt an anchored match, reporting the capture slots of the longest
+// match.
+bool PikeVM::match(std::string_view str, size_t pos,
+                   std::vector<size_t> &slots) {
+  int n = _program->slots();
+  bool matched = false;
+  size_t end = 0;
+  int id = 0;
+
+  _cslots.resize(_program->size() * n);
+  _nslots.resize(_program->size() * n);
+  _slots.assign(n, std::string_view::npos);
+
+  _clist.clear();
+  add_capture(_clist, _cslots, _program->start(), pos);
+
+  _examined = pos;
+  for (size_t p = pos; !_clist.empty(); p++) {
+    _nlist.clear();
+    _examined = p + 1;
+
+    for (unsigned i = 0; i < _clist.size(); i++) {
+      int pc = _clist[i];
+      const Instruction &inst = (*_program)[pc];
+      size_t *thread = &_cslots[pc * n];
+
+      if (inst.op == Instruction::MATCH) {
+        if (!matched || end != p || inst.x < id) {
+          slots.assign(thread, thread + n);
+          id = inst.x;
+        }
+        matched = true;
+        end = p;
+      } else if (p < str.length() && _program->consumes(pc, str[p])) {
+        _slots.assign(thread, thread + n);
+        add_capture(_nlist, _nslots, pc + 1, p + 1);
+      }
+    }
+
+    std::swap(_clist, _nlist);
+    std::swap(_cslots, _nslots);
+  }
+
+  if (matched) {
+    slots[0] = pos;
+    slots[1] = end;
+  }
+  return matched;
+}
+
+// Add pc and everything reachable from it without input to the list. The
+// addresses are added in priority order.
+void PikeVM::add_thread(ThreadList &list, std::vector<size_t> &starts, int pc,
+                        size_t start) {
+  _program->closure(pc, _stack, [&](int pc) {
+    if (list.contains(pc)) {
+      return false;
+    }
+    list.add(pc);
+    starts[pc] = start;
+    return true;
+  });
+}
+
+// Add pc and everything reachable from it without input to the list, in
+// priority order. Each thread takes a copy of the slots of the path which
+// reached it first.
+void PikeVM::add_capture(ThreadList &list, std::vector<size_t> &slots,
+                         int pc, size_t p) {
+  int n = _program->slots();
+
+  _saved.clear();
+  _program->closure(
+      pc, _stack,
+      [&](int pc) {
+        if (list.contains(pc)) {
+          return false;
+        }
+        list.add(pc);
+        if (_program->is_thread(pc)) {
+          std::copy(_slots.begin(), _slots.end(), slots.begin() + pc * n);
+        }
+        return true;
+      },
+      [&](int slot) {
+        _saved.push_back(_slots[slot]);
+        _slots[slot] = p;
+      },
+      [&](int slot) {
+        _slots[slot] = _saved.back();
+        _saved.pop_back();
+      });
+}
@@ -0,0 +1,66 @@
+// File: pike_vm.h
+// Purpose: Run a compiled program by simulating its NFA one input byte at a
+//          time. Every thread advances in lock step, so the running time is
+//          linear in the length of the input.
+// Author: Robert Lowe
+#ifndef PIKE_VM_H
+#define PIKE_VM_H
+#include <vector>
+#include "matcher.h"
+#include "program.h"
+#include "thread_list.h"
+
+class PikeVM : public Matcher {
+public:
+  // construct a vm to run the program, which must outlive the vm
+  PikeVM(const Program *program);
+
+  // Attempt an anchored match of the string beginning at pos, reporting the
+  // end of the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end);
+
+  // Attempt an anchored match, also reporting the smallest match id among
+  // the program's match instructions accepting the longest match.
+  virtual bool match(std::string_view str, size_t pos, size_t &end,
+                     int &id);
+
+  // Search for the leftmost-longest match in one pass over the string. A
+  // new thread is started at every position until a match is found.
+  virtual bool search(std::string_view str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // Attempt an anchored match, reporting the capture slots of the longest
+  // match. Slots 2i and 2i + 1 receive where group i begins and ends, or
+  // npos if the group took no part in the match. Each thread carries its
+  // own slots, and the one preferred by the program's splits wins.
+  bool match(std::string_view str, size_t pos, std::vector<size_t> &slots);
+
+private:
+  const Program *_program;
+  ThreadList _clist;
+  ThreadList _nlist;
+  std::vector<int> _stack;
+
+  // where the thread at each address of each list began
+  std::vector<size_t> _cstart;
+  std::vector<size_t> _nstart;
+
+  // Add pc and everything reachable from it without input to the list,
+  // recording that the thread began at start.
+  void add_thread(ThreadList &list, std::vector<size_t> &starts, int pc,
+                  size_t start);
+
+  // The capture slots of the threads at each address of each list, those
+  // of the thread being added, and the values its saves replaced.
+  std::vector<size_t> _cslots;
+  std::vector<size_t> _nslots;
+  std::vector<size_t> _slots;
+  std::vector<size_t> _saved;
+
+  // Add pc and everything reachable from it without input to the list,
+  // saving the position p into the slots of the threads which pass a save.
+  void add_capture(ThreadList &list, std::vector<size_t> &slots, int pc,
+                   size_t p);
+};
+
+#endif
@@ -0,0 +1,160 @@
+// File: program.cpp
+// Purpose: A compiled regular expression. The program is a flat array of
+//          instructions which together describe a Thompson NFA.
+// Author: Robert Lowe
+#include "program.h"
+#include <algorithm>
+#include <cstddef>
+
+// construct an empty program
+Program::Program() : _start(0), _slots(2) { compute_alphabet(); }
+
+// append an instruction and return its address
+int Program::emit(Instruction::Opcode op, int x, int y) {
+  Instruction inst;
+  inst.op = op;
+  inst.lo = 0;
+  inst.hi = 0;
+  inst.x = x;
+  inst.y = y;
+  _code.push_back(inst);
+
+  if (op == Instruction::SAVE && x >= _slots) {
+    _slots = (x | 1) + 1;
+  }
+  return _code.size() - 1;
+}
+
+// add a byte class to the program and return its index
+int Program::add_class(const ByteSet &set) {
+  // share identical classes
+  for (std::size_t i = 0; i < _classes.size(); i++) {
+    if (_classes[i] == set) {
+      return i;
+    }
+  }
+
+  _classes.push_back(set);
+  return _classes.size() - 1;
+}
+
+// the number of instructions in the program
+int Program::size() const { return _code.size(); }
+
+// retrieve a byte class
+const ByteSet &Program::byte_class(int index) const { return _classes[index]; }
+
+// Partition the bytes into equivalence classes by refining the partition
+// with the set of bytes each instruction consumes.
+void Program::compute_alphabet() {
+  int split[256][2];
+
+  // all the bytes start out in one class
+  for (int c = 0; c < 256; c++) {
+    _symbol[c] = 0;
+  }
+  _alphabet_size = 1;
+
+  for (int pc = 0; pc < size(); pc++) {
+    Instruction::Opcode op = _code[pc].op;
+    if (op != Instruction::CHAR && op != Instruction::RANGE &&
+        op != Instruction::CLASS) {
+      continue;
+    }
+
+    // split each class into the bytes the instruction consumes and the rest
+    for (int k = 0; k < _alphabet_size; k++) {
+      split[k][0] = split[k][1] = -1;
+    }
+    int n = 0;
+    for (int c = 0; c < 256; c++) {
+      int &sym = split[_symbol[c]][consumes(pc, c)];
+      if (sym < 0) {
+        sym = n++;
+      }
+      _symbol[c] = sym;
+    }
+    _alphabet_size = n;
+  }
+
+  for (int c = 255; c >= 0; c--) {
+    _representative[_symbol[c]] = c;
+  }
+}
+
+// the number of byte classes
+int Program::alphabet_size() const { return _alphabet_size; }
+
+// one byte of the class sym
+unsigned char Program::representative(int sym) const {
+  return _representative[sym];
+}
+
+// the class of every byte
+const unsigned char *Program::symbol_map() const { return _symbol; }
+
+// The literal which every match must begin with
+std::string Program::prefix() const {
+  std::string result;
+  int pc = _start;
+
+  // follow the program until the first choice or non-literal
+  for (int steps = 0; steps < size(); steps++) {
+    const Instruction &inst = _code[pc];
+    if (inst.op == Instruction::CHAR) {
+      result += inst.lo;
+      pc++;
+    } else if (inst.op == Instruction::JMP) {
+      pc = inst.x;
+    } else if (inst.op == Instruction::SAVE) {
+      pc++;
+    } else {
+      break;
+    }
+  }
+
+  return result;
+}
+
+// get and set the address of the first instruction
+int Program::start() const { return _start; }
+void Program::start(int pc) { _start = pc; }
+
+// the number of capture slots
+int Program::slots() const { return _slots; }
+
+// add pc and everything reachable from it without input to the list
+void Program::add_closure(ThreadList &list, std::vector<int> &stack,
+                          int pc) const {
+  closure(pc, stack, [&list](int pc) {
+    if (list.contains(pc)) {
+      return false;
+    }
+    list.add(pc);
+    return true;
+  });
+}
+
+// Collect the sorted consuming and matching instructions of the list into
+// key
+void Program::make_key(const ThreadList &list, std::vector<int> &key) const {
+  key.clear();
+  for (unsigned i = 0; i < list.size(); i++) {
+    if (is_thread(list[i])) {
+      key.push_back(list[i]);
+    }
+  }
+  std::sort(key.begin(), key.end());
+}
+
+// the smallest match id among the instructions of a key, or -1
+int Program::accept_id(const std::vector<int> &key) const {
+  int accept = -1;
+  for (auto pc : key) {
+    const Instruction &inst = _code[pc];
+    if (inst.op == Instruction::MATCH && (accept < 0 || inst.x < accept)) {
+      accept = inst.x;
+    }
+  }
+  return accept;
+}
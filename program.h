@@ -0,0 +1,176 @@
+// File: program.h
+// Purpose: A compiled regular expression. The program is a flat array of
+//          instructions which together describe a Thompson NFA.
+// Author: Robert Lowe
+#ifndef PROGRAM_H
+#define PROGRAM_H
+#include <string>
+#include <vector>
+#include "byte_set.h"
+#include "thread_list.h"
+
+struct Instruction {
+  enum Opcode {
+    CHAR,  // consume the byte lo
+    RANGE, // consume a byte in lo..hi
+    CLASS, // consume a byte in the program's class x
+    ANY,   // consume any byte
+    SPLIT, // continue at x and at y, preferring x
+    JMP,   // continue at x
+    SAVE,  // record the position in capture slot x, and continue
+    MATCH  // accept the input, x is the match id
+  };
+
+  Opcode op;
+  unsigned char lo;
+  unsigned char hi;
+  int x;
+  int y;
+};
+
+class Program {
+public:
+  // construct an empty program
+  Program();
+
+  // append an instruction and return its address
+  int emit(Instruction::Opcode op, int x = 0, int y = 0);
+
+  // add a byte class to the program and return its index
+  int add_class(const ByteSet &set);
+
+  // the number of instructions in the program
+  int size() const;
+
+  // retrieve the instruction at address pc
+  const Instruction &operator[](int pc) const { return _code[pc]; }
+  Instruction &operator[](int pc) { return _code[pc]; }
+
+  // retrieve a byte class
+  const ByteSet &byte_class(int index) const;
+
+  // return true if the instruction at pc consumes the byte c
+  bool consumes(int pc, unsigned char c) const {
+    const Instruction &inst = _code[pc];
+    switch (inst.op) {
+    case Instruction::CHAR:
+      return c == inst.lo;
+    case Instruction::RANGE:
+      return c >= inst.lo && c <= inst.hi;
+    case Instruction::CLASS:
+      return _classes[inst.x].contains(c);
+    case Instruction::ANY:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // Return true if the instruction at pc consumes a byte or matches. These
+  // are the threads which survive a closure; the rest only lead to them.
+  bool is_thread(int pc) const {
+    Instruction::Opcode op = _code[pc].op;
+    return op != Instruction::JMP && op != Instruction::SPLIT &&
+           op != Instruction::SAVE;
+  }
+
+  // Partition the bytes into equivalence classes, where two bytes share a
+  // class when every instruction consumes both or neither. Automata index
+  // their transitions by class rather than by byte.
+  void compute_alphabet();
+
+  // the number of byte classes, the class of byte c, and one byte of each
+  // class
+  int alphabet_size() const;
+  unsigned char symbol(unsigned char c) const { return _symbol[c]; }
+  unsigned char representative(int sym) const;
+
+  // the class of every byte
+  const unsigned char *symbol_map() const;
+
+  // The literal which every match must begin with. It is read from the
+  // chain of char instructions at the start of the program.
+  std::string prefix() const;
+
+  // get and set the address of the first instruction
+  int start() const;
+  void start(int pc);
+
+  // The number of capture slots. Slots 2i and 2i + 1 hold where group i
+  // begins and ends, group 0 being the whole match.
+  int slots() const;
+
+  // Walk the instructions reachable from pc without input, in the order the
+  // splits prefer, calling add(pc) on each. add returns false if pc was
+  // already reached, which ends the path. A path passing a save calls
+  // save(slot) before it continues, and restore(slot) once everything
+  // beyond the save has been walked, so the caller can keep the positions
+  // of the current path. The stack is scratch space.
+  template <typename Add, typename Save, typename Restore>
+  void closure(int pc, std::vector<int> &stack, Add add, Save save,
+               Restore restore) const;
+
+  // walk the instructions reachable from pc without input, ignoring saves
+  template <typename Add>
+  void closure(int pc, std::vector<int> &stack, Add add) const {
+    closure(pc, stack, add, [](int) {}, [](int) {});
+  }
+
+  // add pc and everything reachable from it without input to the list
+  void add_closure(ThreadList &list, std::vector<int> &stack, int pc) const;
+
+  // Collect the sorted consuming and matching instructions of the list into
+  // key. Lists with the same key behave the same on every input, so the key
+  // names a dfa state.
+  void make_key(const ThreadList &list, std::vector<int> &key) const;
+
+  // the smallest match id among the instructions of a key, or -1
+  int accept_id(const std::vector<int> &key) const;
+
+private:
+  std::vector<Instruction> _code;
+  std::vector<ByteSet> _classes;
+  int _start;
+  int _slots;
+
+  // the byte equivalence classes
+  int _alphabet_size;
+  unsigned char _symbol[256];
+  unsigned char _representative[256];
+};
+
+// Walk the instructions reachable from pc without input. Jobs on the stack
+// are addresses to visit, or, when negative, a slot -(job + 1) to restore.
+template <typename Add, typename Save, typename Restore>
+void Program::closure(int pc, std::vector<int> &stack, Add add, Save save,
+                      Restore restore) const {
+  stack.clear();
+  stack.push_back(pc);
+
+  while (!stack.empty()) {
+    int job = stack.back();
+    stack.pop_back();
+
+    if (job < 0) {
+      restore(-job - 1);
+      continue;
+    }
+    if (!add(job)) {
+      continue;
+    }
+
+    const Instruction &inst = _code[job];
+    if (inst.op == Instruction::JMP) {
+      stack.push_back(inst.x);
+    } else if (inst.op == Instruction::SPLIT) {
+      stack.push_back(inst.y);
+      stack.push_back(inst.x);
+    } else if (inst.op == Instruction::SAVE) {
+      stack.push_back(-inst.x - 1);
+      save(inst.x);
+      stack.push_back(job + 1);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,186 @@
+// File: program_node.cpp
+// Purpose: A node which matches by running a compiled program.
+// Author: Robert Lowe
+#include "program_node.h"
+#include "nfa_compiler.h"
+#include <cstring>
+#include <vector>
+
+// Construct a node which runs the program with the matcher.
+ProgramNode::ProgramNode(Program *program, Matcher *matcher,
+                         size_t backtrack_bytes, size_t tdfa_state_limit)
+    : _program(program), _matcher(matcher), _tdfa(nullptr),
+      _tdfa_built(false), _tdfa_state_limit(tdfa_state_limit),
+      _backtracker(program, backtrack_bytes), _captures(program),
+      _prefix(program->prefix()) {}
+
+// destroy the matcher and the program
+ProgramNode::~ProgramNode() {
+  delete _tdfa;
+  delete _matcher;
+  delete _program;
+}
+
+// Attempt to match the string beginning at the given position.
+bool ProgramNode::match(const std::string &str, size_t &pos) {
+  return _matcher->match(str, pos, pos);
+}
+
+// Search for the leftmost-longest match beginning at or after pos.
+bool ProgramNode::search(const std::string &str, size_t pos, size_t &start,
+                         size_t &end) {
+  return find(str, pos, start, end);
+}
+
+// Search any buffer for the leftmost-longest match. No match begins before
+// the first occurrence of the prefix, so the search starts there.
+bool ProgramNode::find(std::string_view str, size_t pos, size_t &start,
+                       size_t &end) {
+  if (!_prefix.empty()) {
+    if (pos + _prefix.length() > str.length()) {
+      return false;
+    }
+
+    const char *data = str.data();
+    const void *found;
+    if (_prefix.length() == 1) {
+      found = memchr(data + pos, _prefix[0], str.length() - pos);
+    } else {
+      found = memmem(data + pos, str.length() - pos, _prefix.data(),
+                     _prefix.length());
+    }
+    if (!found) {
+      return false;
+    }
+    pos = (const char *)found - data;
+  }
+
+  return _matcher->search(str, pos, start, end);
+}
+
+// Search for the leftmost-longest match, reporting its span and those of
+// its capture groups. The second pass runs on the input cut off at the end
+// of the match, so it looks at nothing beyond it. The tagged dfa makes it
+// one table lookup per byte. Without one, short matches are backtracked,
+// as that is cheaper than carrying slots through every thread of the Pike
+// VM.
+bool ProgramNode::search(std::string_view str, size_t pos,
+                         std::vector<Span> &spans) {
+  size_t start, end;
+  if (!find(str, pos, start, end)) {
+    return false;
+  }
+
+  if (!_tdfa_built) {
+    _tdfa = Tdfa::build(_program, _tdfa_state_limit);
+    _tdfa_built = true;
+  }
+
+  std::string_view match(str.data(), end);
+  bool found;
+  if (_tdfa) {
+    found = _tdfa->match(match, start, _slots);
+  } else if (_backtracker.fits(end - start)) {
+    found = _backtracker.match(match, start, _slots);
+  } else {
+    found = _captures.match(match, start, _slots);
+  }
+  if (!found) {
+    return false;
+  }
+
+  spans.resize(_slots.size() / 2);
+  for (size_t i = 0; i < spans.size(); i++) {
+    spans[i].start = _slots[2 * i];
+    spans[i].end = _slots[2 * i + 1];
+  }
+  return true;
+}
+
+// the number of capture groups in the program
+int ProgramNode::groups() const { return _program->slots() / 2 - 1; }
+
+// Follow the splits and jumps from the start of the program. The bytes the
+// instructions reached consume begin a match, and reaching a match
+// instruction means the match may be empty.
+bool ProgramNode::first_bytes(ByteSet &set) {
+  ThreadList list(_program->size());
+  std::vector<int> stack;
+  bool nullable = false;
+
+  _program->add_closure(list, stack, _program->start());
+  for (unsigned i = 0; i < list.size(); i++) {
+    const Instruction &inst = (*_program)[list[i]];
+    switch (inst.op) {
+    case Instruction::SPLIT:
+    case Instruction::JMP:
+    case Instruction::SAVE:
+      break;
+    case Instruction::MATCH:
+      nullable = true;
+      break;
+    case Instruction::CLASS:
+      set.merge(_program->byte_class(inst.x));
+      break;
+    case Instruction::ANY:
+      set.fill();
+      break;
+    default:
+      set.add_range(inst.lo, inst.hi);
+      break;
+    }
+  }
+
+  return nullable;
+}
+
+// Copy the program into the compiler's program. The copy is entered by a
+// jump to its start, and each match instruction becomes a jump to the end.
+bool ProgramNode::compile(NfaCompiler &compiler) {
+  std::vector<int> matches;
+  int base = compiler.pc() + 1;
+
+  compiler.emit_jmp(base + _program->start());
+  for (int pc = 0; pc < _program->size(); pc++) {
+    const Instruction &inst = (*_program)[pc];
+    switch (inst.op) {
+    case Instruction::CHAR:
+      compiler.emit_char(inst.lo);
+      break;
+    case Instruction::RANGE:
+      compiler.emit_range(inst.lo, inst.hi);
+      break;
+    case Instruction::CLASS:
+      compiler.emit_set(_program->byte_class(inst.x));
+      break;
+    case Instruction::ANY: {
+      ByteSet any;
+      any.fill();
+      compiler.emit_set(any);
+      break;
+    }
+    case Instruction::SPLIT:
+      compiler.emit_split(base + inst.x, base + inst.y);
+      break;
+    case Instruction::JMP:
+      compiler.emit_jmp(base + inst.x);
+      break;
+    case Instruction::SAVE:
+      compiler.emit_save(inst.x);
+      break;
+    case Instruction::MATCH:
+      matches.push_back(compiler.emit_jmp(-1));
+      break;
+    }
+  }
+
+  for (auto jump : matches) {
+    compiler.patch_x(jump, compiler.pc());
+  }
+
+  return true;
+}
+
+// retrieve the program and the matcher which runs it
+const Program *ProgramNode::program() const { return _program; }
+Matcher *ProgramNode::matcher() const { return _matcher; }
@@ -0,0 +1,79 @@
+// File: program_node.h
+// Purpose: A node which matches by running a compiled program rather than
+//          by walking a tree of nodes.
+// Author: Robert Lowe
+#ifndef PROGRAM_NODE_H
+#define PROGRAM_NODE_H
+#include <string>
+#include <vector>
+#include "backtracker.h"
+#include "matcher.h"
+#include "pike_vm.h"
+#include "program.h"
+#include "regex_node.h"
+#include "tdfa.h"
+
+class ProgramNode : public RegexNode {
+public:
+  // Construct a node which runs the program with the matcher. The node
+  // takes ownership of both. Capture groups are found by a tagged dfa of
+  // at most tdfa_state_limit states. If it would be bigger, groups of
+  // matches whose visited set fits in backtrack_bytes are found by
+  // backtracking, and the rest by a Pike VM.
+  ProgramNode(Program *program, Matcher *matcher,
+              size_t backtrack_bytes = Backtracker::DEFAULT_BUDGET_BYTES,
+              size_t tdfa_state_limit = Tdfa::DEFAULT_STATE_LIMIT);
+
+  // destroy the matcher and the program
+  virtual ~ProgramNode();
+
+  // Attempt to match the string beginning at the given position. The match
+  // is the longest one the program allows.
+  virtual bool match(const std::string &str, size_t &pos);
+
+  // Search for the leftmost-longest match beginning at or after pos.
+  virtual bool search(const std::string &str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // Search any buffer for the leftmost-longest match. When every match
+  // begins with a literal, the search skips ahead to where memchr or memmem
+  // first finds it.
+  bool find(std::string_view str, size_t pos, size_t &start, size_t &end);
+
+  // Search for the leftmost-longest match, reporting its span in spans[0]
+  // and the span of capture group i in spans[i]. The spans are offsets
+  // into str. The matcher finds the match, then a second anchored pass
+  // over just the match finds the groups.
+  bool search(std::string_view str, size_t pos, std::vector<Span> &spans);
+
+  // the number of capture groups in the program
+  int groups() const;
+
+  // the bytes which can begin a match, and whether it may be empty
+  virtual bool first_bytes(ByteSet &set);
+
+  // copy the program into the compiler's program
+  virtual bool compile(NfaCompiler &compiler);
+
+  // retrieve the program and the matcher which runs it
+  const Program *program() const;
+  Matcher *matcher() const;
+
+private:
+  Program *_program;
+  Matcher *_matcher;
+
+  // The engines which find capture groups. The tagged dfa is built by
+  // the first search for groups, and stays nullptr if it is too big.
+  Tdfa *_tdfa;
+  bool _tdfa_built;
+  size_t _tdfa_state_limit;
+  Backtracker _backtracker;
+  PikeVM _captures;
+  std::vector<size_t> _slots;
+
+  // the literal every match begins with
+  std::string _prefix;
+};
+
+#endif
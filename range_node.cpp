@@ -2,6 +2,7 @@
 // Purpose: Definition of a character range node class.
 // Author: Robert Lowe
 #include "range_node.h"
+#include "byte_set.h"
 #include <algorithm>
 
 RangeNode::RangeNode(char start, char end) {
@@ -24,3 +25,16 @@ bool RangeNode::match(const std::string &str, size_t &pos) {
   // If not, return false
   return false;
 }
+
+// a range node matches the set of characters in its range
+bool RangeNode::byte_set(ByteSet &set) {
+  // the range is compared as plain chars, so it may wrap into the bytes
+  // above 127 on platforms where char is signed
+  for (int c = 0; c < 256; c++) {
+    char ch = c;
+    if (ch >= _start && ch <= _end) {
+      set.add(c);
+    }
+  }
+  return true;
+}
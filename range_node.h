@@ -11,6 +11,9 @@ public:
 
   // attempt to match the string at position pos
   virtual bool match(const std::string& str, size_t &pos);
+
+  // a range node matches the set of characters in its range
+  virtual bool byte_set(ByteSet &set);
 private:
   char _start;
   char _end;
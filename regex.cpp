@@ -12,6 +12,9 @@ int main() {
   std::cout << "Enter a regular expression: ";
   std::getline(std::cin, s);
   regex = parser.parse(s);
+  if (!regex) {
+    return 1;
+  }
 
   // attempt matches
   for(;;) {
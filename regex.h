@@ -1,10 +1,13 @@
 // File: regex.h
 // Purpose: General header file for the regex library.
 // Author: Robert Lowe
+#include "capture_node.h"
 #include "character_node.h"
+#include "class_node.h"
 #include "group_node.h"
 #include "inverse_node.h"
 #include "lexer.h"
+#include "literal_node.h"
 #include "one_node.h"
 #include "optional_node.h"
 #include "or_node.h"
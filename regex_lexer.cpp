@@ -3,8 +3,10 @@
 // Author: Robert Lowe
 #include "regex_lexer.h"
 #include "regex.h"
+#include "node_builder.h"
 #include <iostream>
 #include <string>
+#include <string_view>
 
 // The tokens
 enum Token {
@@ -36,17 +38,12 @@ static RegexNode *construct_char_node() {
   OrNode *result = new OrNode();
 
   // Construct the inverse character class
-  OrNode *inv_spec = new OrNode();
-  inv_spec->add_node(new CharacterNode('.'));
-  inv_spec->add_node(new CharacterNode('('));
-  inv_spec->add_node(new CharacterNode(')'));
-  inv_spec->add_node(new CharacterNode('['));
-  inv_spec->add_node(new CharacterNode(']'));
-  inv_spec->add_node(new CharacterNode('*'));
-  inv_spec->add_node(new CharacterNode('+'));
-  inv_spec->add_node(new CharacterNode('?'));
-  inv_spec->add_node(new CharacterNode('|'));
-  result->add_node(new InverseNode(inv_spec));
+  ByteSet inv_spec;
+  for (const char *c = ".()[]*+?|"; *c; c++) {
+    inv_spec.add(*c);
+  }
+  inv_spec.invert();
+  result->add_node(new ClassNode(inv_spec));
 
   // Build the escape sequences
   result->add_node(construct_escaped_node());
@@ -57,7 +54,10 @@ static RegexNode *construct_char_node() {
 // Construct class spec: ([^\]] | \\.)+
 static RegexNode *construct_class_spec_node() {
   OrNode *spec_or = new OrNode();
-  spec_or->add_node(new InverseNode(new CharacterNode(']')));
+  ByteSet not_bracket;
+  not_bracket.add(']');
+  not_bracket.invert();
+  spec_or->add_node(new ClassNode(not_bracket));
   spec_or->add_node(construct_escaped_node());
   return new OneNode(spec_or);
 }
@@ -115,7 +115,7 @@ static RegexNode *construct_range_node() {
 }
 
 // Translate a character
-static char translate_char(const std::string &str) {
+static char translate_char(std::string_view str) {
   // handle the simple characters
   if (str.length() == 1) {
     return str[0];
@@ -138,18 +138,20 @@ static void handle_character(RegexLexer::LexerToken &result) {
   result.node = new CharacterNode(translate_char(result.lexeme));
 }
 
-// Handle the class spec
-static RegexNode *handle_class_spec(const std::string &spec, Lexer &lexer) {
-  OrNode *result = new OrNode();
-  Lexer::Token t;
+// Handle the class spec, collecting its characters and ranges into a set
+static ByteSet handle_class_spec(std::string_view spec, Lexer &lexer) {
+  ByteSet result;
+  Lexer::TokenView t;
 
-  lexer.input(spec);
+  if (!lexer.borrow(spec)) {
+    lexer.input(std::string(spec));
+  }
 
-  while ((t = lexer.next()).tok != RegexLexer::END_OF_INPUT) {
+  while ((t = lexer.next_view()).tok != RegexLexer::END_OF_INPUT) {
     if (t.tok == CHAR_TOK) {
-      result->add_node(new CharacterNode(translate_char(t.lexeme)));
+      result.add(translate_char(t.lexeme));
     } else if (t.tok == RANGE_TOK) {
-      result->add_node(new RangeNode(t.lexeme[0], t.lexeme[2]));
+      RangeNode(t.lexeme[0], t.lexeme[2]).byte_set(result);
     }
   }
 
@@ -157,31 +159,21 @@ static RegexNode *handle_class_spec(const std::string &spec, Lexer &lexer) {
 }
 
 static void handle_class(RegexLexer::LexerToken &result, Lexer &lexer) {
-  std::string spec = result.lexeme.substr(1, result.lexeme.length() - 2);
+  std::string_view spec(result.lexeme);
+  spec = spec.substr(1, spec.length() - 2);
   result.tok = RegexLexer::REGEX_NODE;
-  result.node = handle_class_spec(spec, lexer);
+  result.node = new ClassNode(handle_class_spec(spec, lexer));
 }
 
 static void handle_inv_class(RegexLexer::LexerToken &result, Lexer &lexer) {
   // Extract the specification part (without the surrounding [^ and ])
-  std::string spec = result.lexeme.substr(2, result.lexeme.length() - 3);
-
-  // Create the OrNode for the class specification
-  OrNode *spec_or = new OrNode();
-  lexer.input(spec);
-
-  // Tokenize and handle the class specification
-  Lexer::Token t;
-  while ((t = lexer.next()).tok != RegexLexer::END_OF_INPUT) {
-    if (t.tok == CHAR_TOK) {
-      spec_or->add_node(new CharacterNode(translate_char(t.lexeme)));
-    } else if (t.tok == RANGE_TOK) {
-      spec_or->add_node(new RangeNode(t.lexeme[0], t.lexeme[2]));
-    }
-  }
+  std::string_view spec(result.lexeme);
+  spec = spec.substr(2, spec.length() - 3);
 
-  // Wrap the class specification OrNode in an InverseNode
-  result.node = new InverseNode(spec_or);
+  // The class matches every character the specification does not
+  ByteSet set = handle_class_spec(spec, lexer);
+  set.invert();
+  result.node = new ClassNode(set);
 
   // Set the token type
   result.tok = RegexLexer::REGEX_NODE;
@@ -210,19 +202,20 @@ RegexLexer::RegexLexer() {
   // blank input
   input("");
 
-  // build the main lexer
-  _lexer.add_token(CHAR_TOK, construct_char_node());
-  _lexer.add_token(INV_CLASS_TOK, construct_inv_class_node());
-  _lexer.add_token(CLASS_TOK, construct_class_node());
-  _lexer.add_token(LPAREN_TOK, construct_lparen_node());
-  _lexer.add_token(RPAREN_TOK, construct_rparen_node());
-  _lexer.add_token(PIPE_TOK, construct_pipe_node());
-  _lexer.add_token(WILDCARD_TOK, construct_wildcard_node());
-  _lexer.add_token(QUANT_TOK, construct_quantifier_node());
+  // build the main lexer, sharing the nodes the two lexers have in common
+  NodeBuilder builder;
+  _lexer.add_token(CHAR_TOK, builder.share(construct_char_node()));
+  _lexer.add_token(INV_CLASS_TOK, builder.share(construct_inv_class_node()));
+  _lexer.add_token(CLASS_TOK, builder.share(construct_class_node()));
+  _lexer.add_token(LPAREN_TOK, builder.share(construct_lparen_node()));
+  _lexer.add_token(RPAREN_TOK, builder.share(construct_rparen_node()));
+  _lexer.add_token(PIPE_TOK, builder.share(construct_pipe_node()));
+  _lexer.add_token(WILDCARD_TOK, builder.share(construct_wildcard_node()));
+  _lexer.add_token(QUANT_TOK, builder.share(construct_quantifier_node()));
 
   // build the spec lexer
-  _spec_lexer.add_token(CHAR_TOK, construct_char_node());
-  _spec_lexer.add_token(RANGE_TOK, construct_range_node());
+  _spec_lexer.add_token(CHAR_TOK, builder.share(construct_char_node()));
+  _spec_lexer.add_token(RANGE_TOK, builder.share(construct_range_node()));
 }
 
 // set the input string
@@ -234,17 +227,22 @@ std::string RegexLexer::input() const { return _lexer.input(); }
 // get the current position
 size_t RegexLexer::position() const { return _lexer.position(); }
 
+// convert a position to a line and column
+void RegexLexer::location(size_t pos, size_t &line, size_t &column) {
+  _lexer.location(pos, line, column);
+}
+
 // check to see if we are at the end of the input
 bool RegexLexer::at_end() const { return _lexer.at_end(); }
 
 // get the next RegexNode, null if there is none
 RegexLexer::LexerToken RegexLexer::next() {
   // get the textual node and then do our own translation
-  Lexer::Token lt = _lexer.next();
+  Lexer::TokenView lt = _lexer.next_view();
   LexerToken result;
 
   // copy the basic fields
-  result.lexeme = lt.lexeme;
+  result.lexeme = std::string(lt.lexeme);
   result.pos = lt.pos;
 
   // assume we are building a regex expression
@@ -23,6 +23,9 @@ public:
   //check to see if we are at the end of the input
   bool at_end() const;
 
+  //convert a position to a line and column, both counted from 1
+  void location(size_t pos, size_t &line, size_t &column);
+
   // The tokens emitted by this lexer can optionally contain a regex node,
   // which is the result of the lexing process. Sometimes they will not.
   enum Token {
@@ -3,8 +3,94 @@
 // Author: Robert Lowe
 #include <string>
 #include "regex_node.h"
+#include "byte_set.h"
+#include "nfa_compiler.h"
+#include "node_arena.h"
+
+// Whether the node whose destructor ran last on this thread was in an
+// arena. The base destructor runs last of all, just before operator
+// delete, which has only the node's memory left to go by.
+static thread_local bool deleting_arena_node = false;
+
+// Construct a node with one reference, held by its creator. operator new
+// placed the node in the arena in scope, if there is one.
+RegexNode::RegexNode()
+    : _refs(1), _in_arena(NodeArena::current() != nullptr) {}
 
 // virtual destructor
-RegexNode::~RegexNode() {
-  // This space left intentionally blank.
-}
\ No newline at end of file
+RegexNode::~RegexNode() { deleting_arena_node = _in_arena; }
+
+// add a reference to the node
+RegexNode *RegexNode::ref() {
+  _refs++;
+  return this;
+}
+
+// drop a reference to the node, deleting it with the last one
+void RegexNode::unref(RegexNode *node) {
+  if (node && --node->_refs == 0) {
+    delete node;
+  }
+}
+
+// the number of references to the node
+int RegexNode::references() const { return _refs; }
+
+// Place the node in the arena in scope, or on the heap
+void *RegexNode::operator new(size_t size) {
+  NodeArena *arena = NodeArena::current();
+
+  if (arena) {
+    return arena->allocate(size);
+  }
+  return ::operator new(size);
+}
+
+// Free a node on the heap. A node in an arena is freed with the arena.
+void RegexNode::operator delete(void *ptr) {
+  if (ptr && !deleting_arena_node) {
+    ::operator delete(ptr);
+  }
+}
+
+// By default, search by trying a match at every position in turn.
+bool RegexNode::search(const std::string &str, size_t pos, size_t &start,
+                       size_t &end) {
+  for (; pos <= str.length(); pos++) {
+    size_t p = pos;
+    if (match(str, p)) {
+      start = pos;
+      end = p;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// By default, a node has no byte set.
+bool RegexNode::byte_set(ByteSet &) {
+  return false;
+}
+
+// By default, a node begins with its byte set, or else with anything.
+bool RegexNode::first_bytes(ByteSet &set) {
+  if (byte_set(set)) {
+    return false;
+  }
+
+  set.fill();
+  return true;
+}
+
+// By default, only nodes with a byte set can be compiled.
+bool RegexNode::compile(NfaCompiler &compiler) {
+  ByteSet set;
+
+  if (!byte_set(set)) {
+    return false;
+  }
+
+  compiler.emit_set(set);
+  return true;
+}
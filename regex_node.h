@@ -3,13 +3,38 @@
 // Author: Robert Lowe
 #ifndef REGEX_NODE_H
 #define REGEX_NODE_H
+#include <cstddef>
 #include <string>
 
+class ByteSet;
+class NfaCompiler;
+
 class RegexNode {
 public:
+  // construct a node with one reference, held by its creator
+  RegexNode();
+
   // virtual destructor
   virtual ~RegexNode();
 
+  // Nodes may be shared by several parents, as the NodeBuilder shares
+  // identical subtrees. Each owner holds a reference: ref adds one and
+  // returns the node, and unref drops one, deleting the node with the last.
+  // A node with one reference may simply be deleted. The counts are not
+  // atomic, so trees are built and destroyed by one thread at a time.
+  RegexNode *ref();
+  static void unref(RegexNode *node);
+
+  // the number of references to the node
+  int references() const;
+
+  // Nodes are placed in the NodeArena in scope when they are created, if
+  // there is one. Deleting a node in an arena runs its destructor but
+  // leaves its memory to the arena. Nodes on the heap carry nothing extra
+  // for this.
+  static void *operator new(size_t size);
+  static void operator delete(void *ptr);
+
   // Attempt to match the string beginning at the given position.
   // Parameters:
   //   str - The string to match
@@ -20,6 +45,37 @@ public:
   //   Also, this function should update the position accordingly to point
   //   to the next character after the match.
   virtual bool match(const std::string &str, size_t &pos) = 0;
+
+  // Search for the leftmost match beginning at or after pos.
+  // Parameters:
+  //   str   - The string to search
+  //   pos   - The position in the string to start searching from
+  //   start - Receives the position where the match begins
+  //   end   - Receives the position after the match
+  // Returns:
+  //   true if a match was found, false otherwise
+  // The default tries match at every position in turn.
+  virtual bool search(const std::string &str, size_t pos, size_t &start,
+                      size_t &end);
+
+  // If this node always matches exactly one byte drawn from a fixed set,
+  // store that set and return true. The default answers false.
+  virtual bool byte_set(ByteSet &set);
+
+  // Add every byte which can begin a non-empty match of this node to set,
+  // and return true if the node can also match the empty string. The
+  // answer may be too large but never too small. The default uses the
+  // node's byte set, or else answers any byte and nullable.
+  virtual bool first_bytes(ByteSet &set);
+
+  // Emit the NFA instructions for this node into the compiler's program.
+  // Returns false if the node cannot be compiled. The default compiles any
+  // node which has a byte_set.
+  virtual bool compile(NfaCompiler &compiler);
+
+private:
+  int _refs;
+  bool _in_arena; // whether operator new placed the node in an arena
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,290 @@
+// File: regex_optimizer.cpp
+// Purpose: Rewrite a parsed tree of RegexNodes into a smaller, shallower
+//          tree which matches exactly as the original did.
+// Author: Robert Lowe
+#include <string>
+#include <vector>
+#include "regex_optimizer.h"
+#include "byte_set.h"
+#include "literal_node.h"
+#include "regex.h"
+
+// The quantifiers, as far as collapsing them is concerned
+enum Quantifier { ZERO_OR_MORE, ONE_OR_MORE, ZERO_OR_ONE };
+
+//////////////////////////////////////////
+// Static Helper Functions
+//////////////////////////////////////////
+
+// If the node always matches one byte, c, append c to text and return true.
+// A literal node appends its whole text.
+static bool literal_text(RegexNode *node, std::string &text) {
+  ByteSet set;
+
+  if (LiteralNode *literal = dynamic_cast<LiteralNode *>(node)) {
+    text.append(literal->text());
+    return true;
+  }
+  if (!node->byte_set(set) || set.count() != 1) {
+    return false;
+  }
+  for (int c = 0; c < 256; c++) {
+    if (set.contains(c)) {
+      text += (char)c;
+    }
+  }
+  return true;
+}
+
+// the node matching exactly text
+static RegexNode *make_literal(const std::string &text) {
+  if (text.empty()) {
+    return new GroupNode();
+  } else if (text.length() == 1) {
+    return new CharacterNode(text[0]);
+  }
+
+  return new LiteralNode(text);
+}
+
+// Build the sequence of the given optimized nodes. Groups are spliced in,
+// and each run of literals becomes one literal node.
+static RegexNode *make_sequence(const std::vector<RegexNode *> &nodes) {
+  std::vector<RegexNode *> flat;
+  std::vector<RegexNode *> result;
+
+  for (auto node : nodes) {
+    GroupNode *group = dynamic_cast<GroupNode *>(node);
+    if (group) {
+      flat.insert(flat.end(), group->nodes().begin(), group->nodes().end());
+      group->release_nodes();
+      delete group;
+    } else {
+      flat.push_back(node);
+    }
+  }
+
+  for (size_t i = 0; i < flat.size();) {
+    std::string text;
+    size_t j = i;
+    while (j < flat.size() && flat[j] && literal_text(flat[j], text)) {
+      j++;
+    }
+
+    if (j - i < 2) {
+      // nothing to merge
+      result.push_back(flat[i]);
+      i++;
+      continue;
+    }
+
+    for (; i < j; i++) {
+      delete flat[i];
+    }
+    result.push_back(make_literal(text));
+  }
+
+  if (result.size() == 1 && result[0]) {
+    return result[0];
+  }
+
+  GroupNode *group = new GroupNode();
+  for (auto node : result) {
+    group->add_node(node);
+  }
+  return group;
+}
+
+// the literal every match of an optimized node begins with
+static std::string leading(RegexNode *node) {
+  std::string text;
+
+  GroupNode *group = dynamic_cast<GroupNode *>(node);
+  if (group) {
+    if (!group->nodes().empty() && group->nodes()[0]) {
+      literal_text(group->nodes()[0], text);
+    }
+  } else {
+    literal_text(node, text);
+  }
+
+  return text;
+}
+
+// Remove the first n bytes of the leading literal of an optimized node,
+// returning what is left.
+static RegexNode *strip(RegexNode *node, size_t n) {
+  GroupNode *group = dynamic_cast<GroupNode *>(node);
+
+  if (!group) {
+    std::string text = leading(node);
+    delete node;
+    return make_literal(text.substr(n));
+  }
+
+  std::vector<RegexNode *> nodes(group->nodes().begin(), group->nodes().end());
+  group->release_nodes();
+  delete group;
+  nodes[0] = strip(nodes[0], n);
+  return make_sequence(nodes);
+}
+
+// Build the choice between the given optimized alternatives. Neighbors
+// which begin with the same literal share one copy of it, so that
+// abc|abd is ab(c|d). Greedy, in-order choice is kept, as the shared
+// literal matches the same way whichever alternative is tried.
+static RegexNode *make_choice(const std::vector<RegexNode *> &alternatives) {
+  std::vector<RegexNode *> result;
+
+  for (size_t i = 0; i < alternatives.size();) {
+    std::string prefix = leading(alternatives[i]);
+    size_t j = i + 1;
+
+    // extend the run while it shares some prefix
+    while (!prefix.empty() && j < alternatives.size()) {
+      std::string next = leading(alternatives[j]);
+      size_t n = 0;
+      while (n < prefix.length() && n < next.length() &&
+             prefix[n] == next[n]) {
+        n++;
+      }
+      if (n == 0) {
+        break;
+      }
+      prefix.resize(n);
+      j++;
+    }
+
+    if (j - i < 2) {
+      result.push_back(alternatives[i]);
+      i++;
+      continue;
+    }
+
+    std::vector<RegexNode *> rest;
+    for (; i < j; i++) {
+      rest.push_back(strip(alternatives[i], prefix.length()));
+    }
+    result.push_back(make_sequence({make_literal(prefix), make_choice(rest)}));
+  }
+
+  if (result.size() == 1) {
+    return result[0];
+  }
+
+  OrNode *alt = new OrNode();
+  for (auto node : result) {
+    alt->add_node(node);
+  }
+  return alt;
+}
+
+// Build the quantifier q of an optimized node, collapsing a quantifier of
+// a quantifier. The pair matches the same strings as one quantifier, which
+// is + if both are +, ? if both are ?, and * otherwise.
+static RegexNode *make_quantifier(Quantifier q, RegexNode *node) {
+  Quantifier inner = q;
+  RegexNode *child = nullptr;
+
+  if (ZeroNode *zero = dynamic_cast<ZeroNode *>(node)) {
+    inner = ZERO_OR_MORE;
+    child = zero->release();
+  } else if (OneNode *one = dynamic_cast<OneNode *>(node)) {
+    inner = ONE_OR_MORE;
+    child = one->release();
+  } else if (OptionalNode *opt = dynamic_cast<OptionalNode *>(node)) {
+    inner = ZERO_OR_ONE;
+    child = opt->release();
+  }
+
+  if (child) {
+    delete node;
+    return make_quantifier(q == inner ? q : ZERO_OR_MORE, child);
+  }
+
+  if (q == ZERO_OR_MORE) {
+    return new ZeroNode(node);
+  } else if (q == ONE_OR_MORE) {
+    return new OneNode(node);
+  }
+  return new OptionalNode(node);
+}
+
+//////////////////////////////////////////
+// Optimization Functions
+//////////////////////////////////////////
+
+// Optimize the tree rooted at root.
+RegexNode *optimize_regex(RegexNode *root) {
+  std::vector<RegexNode *> nodes;
+
+  if (GroupNode *group = dynamic_cast<GroupNode *>(root)) {
+    for (auto node : group->nodes()) {
+      nodes.push_back(optimize_regex(node));
+    }
+    group->release_nodes();
+    delete group;
+    return make_sequence(nodes);
+  }
+
+  if (OrNode *alt = dynamic_cast<OrNode *>(root)) {
+    bool complete = true;
+    for (auto node : alt->nodes()) {
+      node = optimize_regex(node);
+
+      // splice in nested ors
+      OrNode *inner = dynamic_cast<OrNode *>(node);
+      if (inner) {
+        nodes.insert(nodes.end(), inner->nodes().begin(), inner->nodes().end());
+        inner->release_nodes();
+        delete inner;
+      } else {
+        nodes.push_back(node);
+      }
+    }
+    alt->release_nodes();
+    delete alt;
+    for (auto node : nodes) {
+      complete = complete && node;
+    }
+
+    // an incomplete tree is left as it is
+    if (complete) {
+      return make_choice(nodes);
+    }
+    alt = new OrNode();
+    for (auto node : nodes) {
+      alt->add_node(node);
+    }
+    return alt;
+  }
+
+  // quantifiers of a complete node are rebuilt around the optimized node
+  Quantifier q = ZERO_OR_MORE;
+  RegexNode *child = nullptr;
+  if (ZeroNode *zero = dynamic_cast<ZeroNode *>(root)) {
+    q = ZERO_OR_MORE;
+    child = zero->node() ? zero->release() : nullptr;
+  } else if (OneNode *one = dynamic_cast<OneNode *>(root)) {
+    q = ONE_OR_MORE;
+    child = one->node() ? one->release() : nullptr;
+  } else if (OptionalNode *opt = dynamic_cast<OptionalNode *>(root)) {
+    q = ZERO_OR_ONE;
+    child = opt->node() ? opt->release() : nullptr;
+  }
+  if (child) {
+    delete root;
+    return make_quantifier(q, optimize_regex(child));
+  }
+
+  // a capture keeps its place, so its boundaries survive the optimization
+  CaptureNode *capture = dynamic_cast<CaptureNode *>(root);
+  if (capture && capture->node()) {
+    int index = capture->index();
+    child = capture->release();
+    delete root;
+    return new CaptureNode(index, optimize_regex(child));
+  }
+
+  return root;
+}
@@ -0,0 +1,22 @@
+// File: regex_optimizer.h
+// Purpose: Rewrite a parsed tree of RegexNodes into a smaller, shallower
+//          tree which matches exactly as the original did.
+// Author: Robert Lowe
+#ifndef REGEX_OPTIMIZER_H
+#define REGEX_OPTIMIZER_H
+#include "regex_node.h"
+
+// Optimize the tree rooted at root, taking it over, and return the root of
+// the result. The tree must not share nodes with any other, as its nodes
+// are rebuilt in place. New nodes are placed in the node arena in scope,
+// if any.
+//   - groups of one node, groups within groups and ors within ors are
+//     flattened
+//   - runs of single characters become one literal node
+//   - literal prefixes shared by neighboring alternatives are factored out
+//   - a quantifier of a quantifier collapses into one, so (a*)* is a*
+// Where the original tree would loop forever, as on (a*)*, the result
+// matches as the collapsed quantifier does.
+RegexNode *optimize_regex(RegexNode *root);
+
+#endif
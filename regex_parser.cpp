@@ -3,12 +3,15 @@
 // Author: Robert Lowe
 #include "regex_parser.h"
 #include "regex.h"
+#include "node_arena.h"
+#include "regex_optimizer.h"
 #include <iostream>
 
+const size_t RegexParser::MAX_DEPTH;
+
 // Constructor
-RegexParser::RegexParser() {
-  // nothing to do here
-}
+RegexParser::RegexParser()
+    : _builder(nullptr), _captures(false), _groups(0), _optimize(true) {}
 
 // Destructor
 RegexParser::~RegexParser() {
@@ -23,16 +26,50 @@ RegexNode *RegexParser::parse(const std::string &str) {
   // get the first token
   next();
 
-  // parse the regular expression
-  return parse_regex();
+  // parse the regular expression, and optimize the tree
+  RegexNode *tree = parse_regex();
+  if (!tree) {
+    return nullptr;
+  }
+  if (_optimize) {
+    tree = optimize_regex(tree);
+  }
+
+  // Share its identical subtrees. Nodes in an arena may be freed with it,
+  // so they are never kept for the trees to come.
+  if (_builder && !NodeArena::current()) {
+    return _builder->intern(tree);
+  }
+  NodeBuilder builder;
+  return builder.intern(tree);
 }
 
+// Parse a regex string, placing its nodes in the arena
+RegexNode *RegexParser::parse(const std::string &str, NodeArena *arena) {
+  NodeArena::Scope scope(arena);
+  return parse(str);
+}
+
+// Turn capture groups on or off
+void RegexParser::captures(bool on) { _captures = on; }
+
+// Turn the optimization of parsed trees on or off
+void RegexParser::optimize(bool on) { _optimize = on; }
+
+// Share subtrees across parses through the caller's builder, or within
+// each tree if builder is nullptr
+void RegexParser::builder(NodeBuilder *builder) { _builder = builder; }
+
 ////////////////////////////////////
 // Utility Methods
 ////////////////////////////////////
 // Display an error at the current token
 void RegexParser::error(const std::string &msg) {
-  std::cerr << msg << " at column " << (_cur.pos+1) << std::endl;
+  size_t line, column;
+
+  _lexer.location(_cur.pos, line, column);
+  std::cerr << msg << " at line " << line << ", column " << column
+            << std::endl;
 }
 
 // Advance the lexer to the next token
@@ -47,71 +84,105 @@ void RegexParser::next() {
 }
 
 ////////////////////////////////////
-// Recursive Descent Methods
+// Parsing Methods
 ////////////////////////////////////
 
 // < Regex >      ::= < Regex > < Match >
 //                    | < Match >
+// < Match-Body > ::= LPAREN < Regex > RPAREN
+//                    | REGEX_NODE
 RegexNode *RegexParser::parse_regex() {
-  GroupNode *group = new GroupNode();
+  _stack.clear();
+  _stack.push_back(Frame{new GroupNode(), nullptr, 0});
+  _groups = 0;
+
+  for (;;) {
+    RegexNode *body;
 
-  while(_cur.tok != RegexLexer::END_OF_INPUT &&
-        _cur.tok != RegexLexer::RPAREN) {
-    group->add_node(parse_match());
+    if (!_stack.back().alt && (_cur.tok == RegexLexer::END_OF_INPUT ||
+                               _cur.tok == RegexLexer::RPAREN)) {
+      // the regex on top of the stack is complete
+      body = _stack.back().group;
+      if (_stack.back().capture) {
+        body = new CaptureNode(_stack.back().capture, body);
+      }
+      _stack.pop_back();
+      if (_stack.empty()) {
+        return body;
+      }
+
+      // it is the body of a parenthesized match
+      if (_cur.tok != RegexLexer::RPAREN) {
+        error("Expected )");
+      } else {
+        next(); // consume )
+      }
+    } else if (_cur.tok == RegexLexer::LPAREN) {
+      if (_stack.size() > MAX_DEPTH) {
+        error("Parentheses nested too deep");
+        abandon();
+        return nullptr;
+      }
+      next(); // consume (
+      _stack.push_back(Frame{new GroupNode(), nullptr,
+                             _captures ? ++_groups : 0});
+      continue;
+    } else if (_cur.tok == RegexLexer::REGEX_NODE) {
+      body = _cur.node;
+      next(); // consume REGEX_NODE
+    } else {
+      error("Unexpected token");
+      body = nullptr;
+    }
+
+    parse_match(body);
   }
+}
 
-  return group;
+// Delete the regexes open on the stack. Each holds only the matches
+// completed within it, so none of them is deeper than MAX_DEPTH.
+void RegexParser::abandon() {
+  for (auto &frame : _stack) {
+    delete frame.group;
+    delete frame.alt;
+  }
+  _stack.clear();
 }
 
 // < Match >      ::= < Match-Body > (ZERO_QUANT | ONE_QUANT | OPTION_QUANT)
 //                    | < Match-Body > OR < Match >
 //                    | < Match-Body >
-RegexNode *RegexParser::parse_match() {
-  // handles all the < Match-Body > cases
-  RegexNode *body = parse_match_body();
+void RegexParser::parse_match(RegexNode *body) {
+  Frame &frame = _stack.back();
 
   // (ZERO_QUANT | ONE_QUANT | OPTION_QUANT)
   // | OR < Match >
   // | ""
-  if( _cur.tok == RegexLexer::ZERO_QUANT) {
+  if (_cur.tok == RegexLexer::ZERO_QUANT) {
     next(); // consume *
-    return new ZeroNode(body);
-  } else if( _cur.tok == RegexLexer::ONE_QUANT) {
+    body = new ZeroNode(body);
+  } else if (_cur.tok == RegexLexer::ONE_QUANT) {
     next(); // consume +
-    return new OneNode(body);
-  } else if( _cur.tok == RegexLexer::OPTION_QUANT) {
+    body = new OneNode(body);
+  } else if (_cur.tok == RegexLexer::OPTION_QUANT) {
     next(); // consume ?
-    return new OptionalNode(body);
-  } else if( _cur.tok == RegexLexer::OR) {
+    body = new OptionalNode(body);
+  } else if (_cur.tok == RegexLexer::OR) {
     next(); // consume |
-    OrNode *or_node = new OrNode();
-    or_node->add_node(body);
-    or_node->add_node(parse_match());
-    return or_node;
-  }
-
-  // if there is nothing after the Match-Body
-  return body;
-}
 
-// < Match-Body > ::= LPAREN < Regex > RPAREN
-//                    | REGEX_NODE
-RegexNode *RegexParser::parse_match_body() {
-  if(_cur.tok == RegexLexer::LPAREN){ 
-    next(); // consume (  
-    RegexNode *result = parse_regex();
-    if( _cur.tok != RegexLexer::RPAREN ) {
-      error("Expected )");
-    } else {
-      next(); // consume )
+    // the match goes on with the next alternative
+    if (!frame.alt) {
+      frame.alt = new OrNode();
     }
-    return result;
-  } else if(_cur.tok == RegexLexer::REGEX_NODE) {
-    RegexNode *result = _cur.node;
-    next(); // consume REGEX_NODE
-    return result;
-  } else {
-    error("Unexpected token");
-    return nullptr;
+    frame.alt->add_node(body);
+    return;
+  }
+
+  // the match is complete
+  if (frame.alt) {
+    frame.alt->add_node(body);
+    body = frame.alt;
+    frame.alt = nullptr;
   }
-}
\ No newline at end of file
+  frame.group->add_node(body);
+}
@@ -3,25 +3,72 @@
 // Author: Robert Lowe
 #ifndef REGEX_PARSER_H
 #define REGEX_PARSER_H
+#include "node_builder.h"
 #include "regex_lexer.h"
 #include "regex_node.h"
 #include <string>
+#include <vector>
+
+class GroupNode;
+class NodeArena;
+class OrNode;
+
 class RegexParser {
 public:
+  // The deepest parentheses may nest. The passes over a tree recurse into
+  // its subtrees, and this keeps every one of them well within a 256 KB
+  // stack.
+  static const size_t MAX_DEPTH = 100;
+
   // Constructor
   RegexParser();
 
   // Destructor
   virtual ~RegexParser();
 
-  // Parse a regex string
+  // Parse a regex string, returning the optimized tree. Identical
+  // subtrees are shared with each other, and with the trees parsed before
+  // through the same builder, but the root belongs to the caller alone.
+  // Returns nullptr, after displaying an error, if parentheses nest more
+  // than MAX_DEPTH deep.
   virtual RegexNode *parse(const std::string &str);
 
+  // Parse a regex string, placing its nodes in the arena. The tree must
+  // not outlive the arena, and shares subtrees only within itself.
+  RegexNode *parse(const std::string &str, NodeArena *arena);
+
+  // Turn capture groups on or off. When on, each parenthesized regex
+  // becomes a CaptureNode numbered from 1 in the order of its left
+  // parenthesis. They are off by default.
+  void captures(bool on);
+
+  // Turn the optimization of parsed trees on or off. It is on by default.
+  // Off, the tree keeps the shape the pattern was written in.
+  void optimize(bool on);
+
+  // Share the subtrees of the trees parsed on the heap through a builder
+  // owned by the caller, so that they are shared across parses. The
+  // builder keeps every distinct subtree it has seen until it is cleared
+  // or destroyed, and must outlive the parser's use of it. By default, or
+  // given nullptr, each parse uses a builder of its own, so sharing stays
+  // within the tree and the parser keeps nothing between parses.
+  void builder(NodeBuilder *builder);
+
 private:
   // The lexer and the current token
   RegexLexer _lexer;
   RegexLexer::LexerToken _cur;
 
+  // the caller's builder sharing subtrees between parses, if any
+  NodeBuilder *_builder;
+
+  // whether groups are captured, and the number of groups so far
+  bool _captures;
+  int _groups;
+
+  // whether parsed trees are optimized
+  bool _optimize;
+
   ////////////////////////////////////
   // Utility Methods
   ////////////////////////////////////
@@ -32,23 +79,40 @@ private:
   void next();
 
   ////////////////////////////////////
-  // Recursive Descent Methods
+  // Parsing Methods
   ////////////////////////////////////
 
+  // A regex being parsed: the group of its matches, the alternatives of
+  // the match in progress after a PIPE, if any, and its capture number,
+  // which is 0 if it is not captured.
+  struct Frame {
+    GroupNode *group;
+    OrNode *alt;
+    int capture;
+  };
+
+  // the regexes open around the current token, kept from parse to parse
+  std::vector<Frame> _stack;
+
   // < Regex >      ::= < Regex > < Match >
   //                    | < Match >
-  RegexNode *parse_regex();
-
   // < Match >      ::= < Match-Body > QUANTIFIER
   //                    | < Match-Body > PIPE < Match >
   //                    | < Match-Body >
-  RegexNode *parse_match();
-
   // < Match-Body > ::= LPAREN < Regex > RPAREN
   //                    | CLASS
   //                    | INVERSE_CLASS
   //                    | CHARACTER
-  RegexNode *parse_match_body();
+  // Parenthesized regexes are parsed on the stack rather than by
+  // recursion, and a chain of alternatives becomes one flat or. Returns
+  // nullptr if they nest too deep.
+  RegexNode *parse_regex();
+
+  // delete the regexes open on the stack after an error ends the parse
+  void abandon();
+
+  // finish a match body in the regex on top of the stack
+  void parse_match(RegexNode *body);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+// File: state_builder.cpp
+// Purpose: Build the states of the DFAs which run a compiled program.
+// Author: Robert Lowe
+#include "state_builder.h"
+#include <algorithm>
+
+const int StateBuilder::MARK;
+const int StateBuilder::SEEDING;
+const int StateBuilder::BEGIN;
+
+// Construct a builder for the program
+StateBuilder::StateBuilder(const Program *program, Kind kind)
+    : _program(program), _kind(kind), _list(program->size()) {
+  if (kind != REVERSE) {
+    return;
+  }
+
+  // the reverse automaton follows the jumps, splits and saves backward
+  _preds.resize(program->size());
+  for (int pc = 0; pc < program->size(); pc++) {
+    const Instruction &inst = (*program)[pc];
+    if (inst.op == Instruction::JMP) {
+      _preds[inst.x].push_back(pc);
+    } else if (inst.op == Instruction::SPLIT) {
+      _preds[inst.x].push_back(pc);
+      _preds[inst.y].push_back(pc);
+    } else if (inst.op == Instruction::SAVE) {
+      _preds[pc + 1].push_back(pc);
+    }
+  }
+}
+
+// Build the key of the start state
+void StateBuilder::start(std::vector<int> &key) {
+  _list.clear();
+  key.clear();
+
+  if (_kind == ANCHORED) {
+    _program->add_closure(_list, _stack, _program->start());
+    _program->make_key(_list, key);
+  } else if (_kind == SEARCH) {
+    _program->add_closure(_list, _stack, _program->start());
+    add_group(0, key);
+    finish_search(true, key);
+  } else {
+    // a match ends at every match instruction
+    for (int pc = 0; pc < _program->size(); pc++) {
+      if ((*_program)[pc].op == Instruction::MATCH) {
+        add_reverse_closure(pc);
+      }
+    }
+    make_reverse_key(key);
+  }
+}
+
+// Build the key of the state reached from key on the byte c
+void StateBuilder::step(const std::vector<int> &key, unsigned char c,
+                        std::vector<int> &next) {
+  _list.clear();
+  next.clear();
+
+  if (_kind == ANCHORED) {
+    for (auto pc : key) {
+      if (_program->consumes(pc, c)) {
+        _program->add_closure(_list, _stack, pc + 1);
+      }
+    }
+    _program->make_key(_list, next);
+  } else if (_kind == SEARCH) {
+    // step each group in turn, so a thread stays with the earliest start
+    // which reaches it
+    size_t i = 0;
+    while (i < key.size() && key[i] != SEEDING) {
+      unsigned first = _list.size();
+      for (; key[i] != MARK; i++) {
+        if (_program->consumes(key[i], c)) {
+          _program->add_closure(_list, _stack, key[i] + 1);
+        }
+      }
+      i++;
+      add_group(first, next);
+    }
+
+    // start a match at the next position
+    bool seeding = i < key.size();
+    if (seeding) {
+      unsigned first = _list.size();
+      _program->add_closure(_list, _stack, _program->start());
+      add_group(first, next);
+    }
+    finish_search(seeding, next);
+  } else {
+    for (auto pc : key) {
+      if (pc != BEGIN && _program->consumes(pc, c)) {
+        add_reverse_closure(pc);
+      }
+    }
+    make_reverse_key(next);
+  }
+}
+
+// The id the state named by key accepts, or -1
+int StateBuilder::accept(const std::vector<int> &key) const {
+  if (_kind == ANCHORED) {
+    return _program->accept_id(key);
+  }
+  if (_kind == REVERSE) {
+    return !key.empty() && key.back() == BEGIN ? 0 : -1;
+  }
+
+  // only the last group of a search key can match
+  int accept = -1;
+  for (auto pc : key) {
+    if (pc >= 0) {
+      const Instruction &inst = (*_program)[pc];
+      if (inst.op == Instruction::MATCH && (accept < 0 || inst.x < accept)) {
+        accept = inst.x;
+      }
+    }
+  }
+  return accept;
+}
+
+// Collect the threads added to _list from index first on as a group
+void StateBuilder::add_group(unsigned first, std::vector<int> &key) {
+  size_t begin = key.size();
+  for (unsigned i = first; i < _list.size(); i++) {
+    if (_program->is_thread(_list[i])) {
+      key.push_back(_list[i]);
+    }
+  }
+  if (key.size() > begin) {
+    std::sort(key.begin() + begin, key.end());
+    key.push_back(MARK);
+  }
+}
+
+// Drop every group after the first which matches
+void StateBuilder::finish_search(bool seeding, std::vector<int> &key) {
+  bool matched = false;
+  for (size_t i = 0; i < key.size(); i++) {
+    if (key[i] == MARK) {
+      if (matched) {
+        key.resize(i + 1);
+        break;
+      }
+    } else if ((*_program)[key[i]].op == Instruction::MATCH) {
+      matched = true;
+    }
+  }
+
+  if (seeding && !matched) {
+    key.push_back(SEEDING);
+  }
+}
+
+// Add pc and everything which reaches it without input to _list
+void StateBuilder::add_reverse_closure(int pc) {
+  _stack.clear();
+  _stack.push_back(pc);
+
+  while (!_stack.empty()) {
+    pc = _stack.back();
+    _stack.pop_back();
+
+    if (_list.contains(pc)) {
+      continue;
+    }
+    _list.add(pc);
+    _stack.insert(_stack.end(), _preds[pc].begin(), _preds[pc].end());
+  }
+}
+
+// Collect the consuming instructions leading into _list as a reverse key.
+// Every consuming instruction continues at the next address, so those are
+// the ones just before an address in the list.
+void StateBuilder::make_reverse_key(std::vector<int> &key) {
+  bool begin = false;
+  key.clear();
+  for (unsigned i = 0; i < _list.size(); i++) {
+    int pc = _list[i];
+    if (pc == _program->start()) {
+      begin = true;
+    }
+    if (pc > 0 && _program->is_thread(pc - 1) &&
+        (*_program)[pc - 1].op != Instruction::MATCH) {
+      key.push_back(pc - 1);
+    }
+  }
+  std::sort(key.begin(), key.end());
+  if (begin) {
+    key.push_back(BEGIN);
+  }
+}
@@ -0,0 +1,72 @@
+// File: state_builder.h
+// Purpose: Build the states of the DFAs which run a compiled program. Each
+//          state is named by a key listing the NFA instructions it is made
+//          of, and the builder finds the key of the start state, the key
+//          reached on each byte, and the id each key accepts.
+// Author: Robert Lowe
+#ifndef STATE_BUILDER_H
+#define STATE_BUILDER_H
+#include <vector>
+#include "program.h"
+
+class StateBuilder {
+public:
+  // the automata which can be built from a program
+  enum Kind {
+    ANCHORED, // run forward from a fixed start, accepting where matches end
+    SEARCH,   // run forward, starting a match at every byte until one ends,
+              // and accepting where the leftmost-longest match ends
+    REVERSE   // run backward from the end of a match, accepting where it
+              // begins
+  };
+
+  // construct a builder for the program, which must outlive the builder
+  StateBuilder(const Program *program, Kind kind);
+
+  // the kind of automaton being built
+  Kind kind() const { return _kind; }
+
+  // build the key of the start state
+  void start(std::vector<int> &key);
+
+  // build the key of the state reached from key on the byte c
+  void step(const std::vector<int> &key, unsigned char c,
+            std::vector<int> &next);
+
+  // the id the state named by key accepts, or -1. The empty key names the
+  // dead state.
+  int accept(const std::vector<int> &key) const;
+
+private:
+  // A search key lists the threads of each start position still running,
+  // earliest first, each list sorted and ended by MARK. SEEDING ends the
+  // key while no match has been found, so new positions are still started.
+  // A reverse key ends with BEGIN when the state accepts.
+  static const int MARK = -1;
+  static const int SEEDING = -2;
+  static const int BEGIN = -1;
+
+  const Program *_program;
+  Kind _kind;
+  ThreadList _list;
+  std::vector<int> _stack;
+
+  // the instructions which continue at each address without input
+  std::vector<std::vector<int>> _preds;
+
+  // Collect the threads added to _list from index first on as a group of
+  // a search key, dropping the group if it is empty.
+  void add_group(unsigned first, std::vector<int> &key);
+
+  // Drop every group after the first which matches. A match also ends the
+  // seeding of new threads.
+  void finish_search(bool seeding, std::vector<int> &key);
+
+  // add pc and everything which reaches it without input to _list
+  void add_reverse_closure(int pc);
+
+  // collect the consuming instructions leading into _list as a reverse key
+  void make_reverse_key(std::vector<int> &key);
+};
+
+#endif
@@ -0,0 +1,183 @@
+// File: stream_matcher.cpp
+// Purpose: Find the matches of a regular expression in a stream which
+//          arrives in chunks.
+// Author: Robert Lowe
+#include "stream_matcher.h"
+#include "nfa_compiler.h"
+#include "regex_parser.h"
+
+const size_t StreamMatcher::DEFAULT_MAX_PENDING;
+const size_t StreamMatcher::DEFAULT_MAX_QUEUED;
+
+// Construct a matcher for the pattern
+StreamMatcher::StreamMatcher(const std::string &pattern, size_t max_pending,
+                             size_t max_queued)
+    : _max_pending(max_pending), _max_queued(max_queued) {
+  RegexParser parser;
+  NfaCompiler compiler;
+  RegexNode *tree = parser.parse(pattern);
+
+  _program = compiler.compile(tree);
+  delete tree;
+
+  if (_program) {
+    _clist.resize(_program->size());
+    _nlist.resize(_program->size());
+    _cstart.resize(_program->size());
+    _nstart.resize(_program->size());
+  }
+  reset();
+}
+
+// destroy the matcher and its program
+StreamMatcher::~StreamMatcher() { delete _program; }
+
+// return true if the pattern was compiled
+bool StreamMatcher::valid() const { return _program != nullptr; }
+
+// Scan the next chunk of the stream, until the queue is full
+size_t StreamMatcher::feed(std::string_view chunk) {
+  size_t n = 0;
+
+  if (!_program) {
+    return chunk.length();
+  }
+
+  while (n < chunk.length() && _matches.size() < _max_queued) {
+    push((unsigned char)chunk[n++]);
+  }
+
+  return n;
+}
+
+// end the stream, completing any match still in progress
+void StreamMatcher::finish() {
+  if (_program) {
+    push(-1);
+  }
+}
+
+// Take the next completed match from the queue
+bool StreamMatcher::next_match(size_t &start, size_t &end) {
+  if (_matches.empty()) {
+    return false;
+  }
+
+  start = _matches.front().first;
+  end = _matches.front().second;
+  _matches.pop_front();
+  return true;
+}
+
+// start a new stream at offset 0
+void StreamMatcher::reset() {
+  _clist.clear();
+  _nlist.clear();
+  _offset = 0;
+  _matched = false;
+  _start = _end = 0;
+  _pending.clear();
+  _done = false;
+  _empty_at = std::string::npos;
+  _matches.clear();
+}
+
+// the number of bytes scanned so far
+size_t StreamMatcher::offset() const { return _offset; }
+
+// Step the byte c through the threads, then repeat any held back bytes for as
+// long as matches complete
+void StreamMatcher::push(int c) {
+  step(c);
+
+  while (_done) {
+    std::string redo;
+    redo.swap(_pending);
+    complete();
+
+    // the held back bytes follow the match, so they are searched again
+    size_t i = 0;
+    while (i < redo.size() && !_done) {
+      step((unsigned char)redo[i++]);
+    }
+
+    if (_done) {
+      // what is left must wait for the match just found to complete
+      _pending.append(redo, i, std::string::npos);
+    } else if (c < 0) {
+      step(-1);
+    }
+  }
+}
+
+// Advance the threads over one byte, or over the end of the stream. This is
+// one step of the leftmost-longest search in PikeVM::search.
+void StreamMatcher::step(int c) {
+  size_t p = _offset;
+
+  // threads beginning here have the lowest priority, and are not needed
+  // once something to the left has matched
+  if (!_matched && p != _empty_at) {
+    add_thread(_clist, _cstart, _program->start(), p);
+  }
+
+  _nlist.clear();
+  for (unsigned i = 0; i < _clist.size(); i++) {
+    int pc = _clist[i];
+    size_t s = _cstart[pc];
+
+    // a thread to the right of a match can never win
+    if (_matched && s > _start) {
+      continue;
+    }
+
+    if ((*_program)[pc].op == Instruction::MATCH) {
+      if (!_matched || s < _start || (s == _start && p > _end)) {
+        _start = s;
+        _end = p;
+        _pending.clear();
+      }
+      _matched = true;
+    } else if (c >= 0 && _program->consumes(pc, c)) {
+      add_thread(_nlist, _nstart, pc + 1, s);
+    }
+  }
+
+  std::swap(_clist, _nlist);
+  std::swap(_cstart, _nstart);
+
+  if (c >= 0) {
+    _offset++;
+    if (_matched) {
+      _pending += (char)c;
+    }
+  }
+
+  _done = _matched &&
+          (_clist.empty() || c < 0 || _pending.size() > _max_pending);
+}
+
+// queue the match found so far and restart the search at its end
+void StreamMatcher::complete() {
+  _matches.push_back(std::make_pair(_start, _end));
+  _empty_at = _start == _end ? _end : std::string::npos;
+
+  _clist.clear();
+  _offset = _end;
+  _matched = false;
+  _done = false;
+}
+
+// Add pc and everything reachable from it without input to the list. The
+// addresses are added in priority order.
+void StreamMatcher::add_thread(ThreadList &list, std::vector<size_t> &starts,
+                               int pc, size_t start) {
+  _program->closure(pc, _stack, [&](int pc) {
+    if (list.contains(pc)) {
+      return false;
+    }
+    list.add(pc);
+    starts[pc] = start;
+    return true;
+  });
+}
@@ -0,0 +1,111 @@
+// File: stream_matcher.h
+// Purpose: Find the matches of a regular expression in a stream which
+//          arrives in chunks. The automaton's threads are kept between
+//          chunks, so the chunks are never joined together, and each match
+//          is reported with its offsets from the start of the stream as
+//          soon as it can no longer grow.
+// Author: Robert Lowe
+#ifndef STREAM_MATCHER_H
+#define STREAM_MATCHER_H
+#include <string>
+#include <deque>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "pike_vm.h"
+#include "program.h"
+
+class StreamMatcher {
+public:
+  // The most bytes held back while a match might still grow. Once this
+  // many have been held, the match found so far is reported as it is.
+  static const size_t DEFAULT_MAX_PENDING = 64 * 1024;
+
+  // The most completed matches waiting to be taken before feed() stops
+  // scanning
+  static const size_t DEFAULT_MAX_QUEUED = 1024;
+
+  // Construct a matcher for the pattern. If the pattern cannot be compiled,
+  // valid() is false and nothing will match.
+  StreamMatcher(const std::string &pattern,
+                size_t max_pending = DEFAULT_MAX_PENDING,
+                size_t max_queued = DEFAULT_MAX_QUEUED);
+
+  // destroy the matcher and its program
+  virtual ~StreamMatcher();
+
+  // return true if the pattern was compiled
+  bool valid() const;
+
+  // Scan the next chunk of the stream, returning the number of its bytes
+  // scanned. The matches it completes are queued for next_match(). Once
+  // max_queued of them are waiting, scanning stops short, so that memory
+  // stays bounded however long the stream; the rest of the chunk is fed
+  // again after the queue is drained. The chunk need not outlive the call.
+  size_t feed(std::string_view chunk);
+
+  // End the stream, completing any match still in progress. This may
+  // queue a match for each byte held back, beyond max_queued.
+  void finish();
+
+  // Take the next completed match from the queue, as start..end offsets
+  // from the start of the stream. Returns false if the queue is empty.
+  bool next_match(size_t &start, size_t &end);
+
+  // start a new stream at offset 0
+  void reset();
+
+  // the number of bytes scanned so far
+  size_t offset() const;
+
+private:
+  Program *_program;
+  size_t _max_pending;
+  size_t _max_queued;
+
+  // the threads, and where each one began
+  ThreadList _clist;
+  ThreadList _nlist;
+  std::vector<size_t> _cstart;
+  std::vector<size_t> _nstart;
+  std::vector<int> _stack;
+
+  // the offset of the next byte to be stepped
+  size_t _offset;
+
+  // the leftmost-longest match found so far, if any
+  bool _matched;
+  size_t _start;
+  size_t _end;
+
+  // The bytes stepped since the end of the match found so far. If the
+  // match does not grow, the search for the next match resumes at its end
+  // and these are stepped again.
+  std::string _pending;
+
+  // set when the match found so far can no longer grow
+  bool _done;
+
+  // where the last match ended if it was empty, since no match may begin
+  // there again
+  size_t _empty_at;
+
+  // the completed matches not yet taken
+  std::deque<std::pair<size_t, size_t>> _matches;
+
+  // step the byte c through the threads, then repeat any held back bytes
+  // for as long as matches complete. c is -1 at the end of the stream.
+  void push(int c);
+
+  // advance the threads over one byte, or over the end of the stream
+  void step(int c);
+
+  // queue the match found so far and restart the search at its end
+  void complete();
+
+  // add pc and everything reachable from it without input to the list
+  void add_thread(ThreadList &list, std::vector<size_t> &starts, int pc,
+                  size_t start);
+};
+
+#endif
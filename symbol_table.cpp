@@ -0,0 +1,140 @@
+// File: symbol_table.cpp
+// Purpose: Intern strings as small integer symbols. Each distinct string is
+//          stored once in an arena, and equal strings always receive the
+//          same symbol, so they can be compared as integers.
+// Author: Robert Lowe
+#include "symbol_table.h"
+#include <cstring>
+
+// the size of an arena block, and of the largest string sharing one
+static const size_t BLOCK_SIZE = 64 * 1024;
+static const size_t SHARED_LIMIT = BLOCK_SIZE / 8;
+
+// construct an empty table
+SymbolTable::SymbolTable()
+    : _slots(64, -1), _free(nullptr), _left(0), _block_bytes(0) {}
+
+// Return the symbol of str, adding it to the table if it is new
+int SymbolTable::intern(std::string_view str) {
+  uint64_t h = hash(str);
+  size_t slot = probe(str, h);
+
+  if (_slots[slot] >= 0) {
+    return _slots[slot];
+  }
+
+  // add the symbol, keeping the table at most half full
+  Symbol symbol;
+  symbol.str = store(str);
+  symbol.length = str.length();
+  symbol.hash = h;
+  _symbols.push_back(symbol);
+  _slots[slot] = _symbols.size() - 1;
+  if (_symbols.size() * 2 > _slots.size()) {
+    grow();
+  }
+
+  return _symbols.size() - 1;
+}
+
+// return the symbol of str, or -1 if it is not in the table
+int SymbolTable::find(std::string_view str) const {
+  return _slots[probe(str, hash(str))];
+}
+
+// the string of a symbol
+std::string_view SymbolTable::name(int symbol) const {
+  return std::string_view(_symbols[symbol].str, _symbols[symbol].length);
+}
+
+// the number of symbols
+size_t SymbolTable::size() const { return _symbols.size(); }
+
+// the bytes used by the table and its strings
+size_t SymbolTable::bytes() const {
+  return _block_bytes + _symbols.capacity() * sizeof(Symbol) +
+         _slots.capacity() * sizeof(int);
+}
+
+// Hash a string eight bytes at a time, multiplying in each word
+uint64_t SymbolTable::hash(std::string_view str) {
+  const uint64_t K = 0x9e3779b97f4a7c15ULL;
+  uint64_t h = str.length() * K;
+  const char *p = str.data();
+  size_t n = str.length();
+  uint64_t word;
+
+  for (; n >= 8; p += 8, n -= 8) {
+    memcpy(&word, p, 8);
+    h = (h ^ word) * K;
+    h ^= h >> 29;
+  }
+  if (n > 0) {
+    word = 0;
+    memcpy(&word, p, n);
+    h = (h ^ word) * K;
+  }
+
+  return h ^ (h >> 32);
+}
+
+// find the slot holding str or the empty slot where it belongs
+size_t SymbolTable::probe(std::string_view str, uint64_t h) const {
+  size_t mask = _slots.size() - 1;
+
+  for (size_t slot = h & mask;; slot = (slot + 1) & mask) {
+    int index = _slots[slot];
+    if (index < 0) {
+      return slot;
+    }
+    const Symbol &symbol = _symbols[index];
+    if (symbol.hash == h && symbol.length == str.length() &&
+        memcmp(symbol.str, str.data(), str.length()) == 0) {
+      return slot;
+    }
+  }
+}
+
+// copy a string into the arena
+const char *SymbolTable::store(std::string_view str) {
+  size_t n = str.length();
+  char *result;
+
+  if (n > SHARED_LIMIT) {
+    // a long string gets a block of its own
+    _blocks.emplace_back(new char[n]);
+    _block_bytes += n;
+    result = _blocks.back().get();
+  } else {
+    if (n > _left) {
+      _blocks.emplace_back(new char[BLOCK_SIZE]);
+      _block_bytes += BLOCK_SIZE;
+      _free = _blocks.back().get();
+      _left = BLOCK_SIZE;
+    }
+    result = _free;
+    _free += n;
+    _left -= n;
+  }
+
+  if (n > 0) {
+    memcpy(result, str.data(), n);
+  }
+  return result;
+}
+
+// double the number of slots, placing each symbol again
+void SymbolTable::grow() {
+  std::vector<int> slots(_slots.size() * 2, -1);
+  size_t mask = slots.size() - 1;
+
+  for (size_t i = 0; i < _symbols.size(); i++) {
+    size_t slot = _symbols[i].hash & mask;
+    while (slots[slot] >= 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = i;
+  }
+
+  _slots.swap(slots);
+}
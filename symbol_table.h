@@ -0,0 +1,66 @@
+// File: symbol_table.h
+// Purpose: Intern strings as small integer symbols. Each distinct string is
+//          stored once in an arena, and equal strings always receive the
+//          same symbol, so they can be compared as integers.
+// Author: Robert Lowe
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+class SymbolTable {
+public:
+  // construct an empty table
+  SymbolTable();
+
+  // Return the symbol of str, adding it to the table if it is new. Symbols
+  // are numbered from 0 in the order they were added.
+  int intern(std::string_view str);
+
+  // return the symbol of str, or -1 if it is not in the table
+  int find(std::string_view str) const;
+
+  // the string of a symbol, which stays valid as long as the table does
+  std::string_view name(int symbol) const;
+
+  // the number of symbols
+  size_t size() const;
+
+  // the bytes used by the table and its strings
+  size_t bytes() const;
+
+private:
+  struct Symbol {
+    const char *str;
+    size_t length;
+    uint64_t hash;
+  };
+
+  // the symbols, and an open addressed table of their indices where -1
+  // marks an empty slot
+  std::vector<Symbol> _symbols;
+  std::vector<int> _slots;
+
+  // the strings are copied into large blocks
+  std::vector<std::unique_ptr<char[]>> _blocks;
+  char *_free;
+  size_t _left;
+  size_t _block_bytes;
+
+  // hash a string
+  static uint64_t hash(std::string_view str);
+
+  // find the slot holding str or the empty slot where it belongs
+  size_t probe(std::string_view str, uint64_t h) const;
+
+  // copy a string into the arena
+  const char *store(std::string_view str);
+
+  // double the number of slots
+  void grow();
+};
+
+#endif
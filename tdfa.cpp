@@ -0,0 +1,246 @@
+// File: tdfa.cpp
+// Purpose: Find the capture groups of a match with a tagged DFA.
+// Author: Robert Lowe
+#include "tdfa.h"
+#include <map>
+#include <utility>
+
+const size_t Tdfa::DEFAULT_STATE_LIMIT;
+const int Tdfa::DEAD;
+
+//////////////////////////////////////////
+// Static Helper Functions
+//////////////////////////////////////////
+
+// The register values of a thread under construction: a register of the
+// state the thread came from, unset, or the position after the byte.
+static const int UNSET = -1;
+static const int POSITION = -2;
+
+// Add the consuming and matching instructions reachable from pc without
+// input to threads, in priority order, each followed by the registers of
+// its slots. An instruction already seen is not reached again, and a save
+// sets its slot to the position, keeping the old value in saved until the
+// path returns.
+static void add_closure(const Program *program, ThreadList &seen,
+                        std::vector<int> &regs, std::vector<int> &stack,
+                        std::vector<int> &saved, int pc,
+                        std::vector<int> &threads) {
+  saved.clear();
+  program->closure(
+      pc, stack,
+      [&](int pc) {
+        if (seen.contains(pc)) {
+          return false;
+        }
+        seen.add(pc);
+        if (program->is_thread(pc)) {
+          threads.push_back(pc);
+          threads.insert(threads.end(), regs.begin(), regs.end());
+        }
+        return true;
+      },
+      [&](int slot) {
+        saved.push_back(regs[slot]);
+        regs[slot] = POSITION;
+      },
+      [&](int slot) {
+        regs[slot] = saved.back();
+        saved.pop_back();
+      });
+}
+
+// Rename the registers of threads to 0, 1, ... in the order they first
+// appear, making the key of the state. Each new register's source, an old
+// register or POSITION, goes to sources.
+static void make_key(const std::vector<int> &threads, int slots,
+                     std::vector<int> &key, std::vector<int> &sources) {
+  std::map<int, int> names;
+
+  key.clear();
+  sources.clear();
+  for (size_t i = 0; i < threads.size(); i++) {
+    int value = threads[i];
+    if (i % (slots + 1) == 0 || value == UNSET) {
+      key.push_back(value);
+      continue;
+    }
+
+    auto found = names.find(value);
+    if (found == names.end()) {
+      found = names.emplace(value, sources.size()).first;
+      sources.push_back(value);
+    }
+    key.push_back(found->second);
+  }
+}
+
+//////////////////////////////////////////
+// Tdfa Methods
+//////////////////////////////////////////
+
+// construct an empty tagged dfa
+Tdfa::Tdfa()
+    : _stride(1), _start(DEAD), _start_ops(-1), _registers(0), _slots(0) {}
+
+// Build the tagged dfa by subset construction. The states are ordered
+// lists of threads, as in the Pike VM, along with the register holding
+// each slot of each thread. Threads which set the same slot on the same
+// transition all set it to the same position, so they share a register.
+Tdfa *Tdfa::build(const Program *program, size_t state_limit) {
+  Tdfa *tdfa = new Tdfa();
+  std::map<std::vector<int>, int> states;
+  std::vector<std::vector<int>> keys;
+  ThreadList seen(program->size());
+  std::vector<int> stack, saved, regs, threads, key, sources;
+  int slots = program->slots();
+  int width = slots + 1;
+
+  tdfa->_slots = slots;
+  tdfa->_stride = program->alphabet_size();
+  for (int c = 0; c < 256; c++) {
+    tdfa->_symbol[c] = program->symbol(c);
+  }
+
+  // the dead state has no threads
+  states[key] = DEAD;
+  keys.push_back(key);
+
+  // the start state, whose registers are all set to the start position
+  regs.assign(slots, UNSET);
+  add_closure(program, seen, regs, stack, saved, program->start(), threads);
+  make_key(threads, slots, key, sources);
+  if (states.find(key) == states.end()) {
+    states[key] = keys.size();
+    keys.push_back(key);
+  }
+  tdfa->_start = states[key];
+  if (!sources.empty()) {
+    tdfa->_start_ops = tdfa->_code.size();
+    tdfa->_code.push_back(sources.size());
+    tdfa->_code.insert(tdfa->_code.end(), sources.size(), -1);
+  }
+  tdfa->_registers = sources.size();
+
+  // build the transitions of each state in turn, discovering new ones
+  for (size_t s = 0; s < keys.size(); s++) {
+    // the state accepts the first match with the smallest id
+    int accept = -1;
+    for (size_t i = 0; i < keys[s].size(); i += width) {
+      const Instruction &inst = (*program)[keys[s][i]];
+      if (inst.op == Instruction::MATCH &&
+          (accept < 0 || inst.x < (*program)[keys[s][accept]].x)) {
+        accept = i;
+      }
+    }
+    if (accept < 0) {
+      tdfa->_final.push_back(-1);
+    } else {
+      tdfa->_final.push_back(tdfa->_code.size());
+      tdfa->_code.insert(tdfa->_code.end(), keys[s].begin() + accept + 1,
+                         keys[s].begin() + accept + width);
+    }
+
+    for (int sym = 0; sym < tdfa->_stride; sym++) {
+      unsigned char c = program->representative(sym);
+      seen.clear();
+      threads.clear();
+      for (size_t i = 0; i < keys[s].size(); i += width) {
+        if (program->consumes(keys[s][i], c)) {
+          regs.assign(keys[s].begin() + i + 1, keys[s].begin() + i + width);
+          add_closure(program, seen, regs, stack, saved, keys[s][i] + 1,
+                      threads);
+        }
+      }
+      make_key(threads, slots, key, sources);
+
+      auto found = states.find(key);
+      if (found == states.end()) {
+        if (keys.size() >= state_limit) {
+          delete tdfa;
+          return nullptr;
+        }
+        found = states.emplace(key, keys.size()).first;
+        keys.push_back(key);
+      }
+      tdfa->_table.push_back(found->second);
+
+      // a transition which keeps every register where it is needs no code
+      bool identity = true;
+      for (size_t k = 0; k < sources.size(); k++) {
+        identity = identity && sources[k] == (int)k;
+      }
+      if (identity) {
+        tdfa->_ops.push_back(-1);
+        continue;
+      }
+      tdfa->_ops.push_back(tdfa->_code.size());
+      tdfa->_code.push_back(sources.size());
+      for (auto source : sources) {
+        tdfa->_code.push_back(source == POSITION ? -1 : source);
+      }
+      if ((int)sources.size() > tdfa->_registers) {
+        tdfa->_registers = sources.size();
+      }
+    }
+  }
+
+  tdfa->_regs.resize(tdfa->_registers);
+  tdfa->_next.resize(tdfa->_registers);
+  return tdfa;
+}
+
+// Match the whole of str from pos on, reporting the capture slots
+bool Tdfa::match(std::string_view str, size_t pos,
+                 std::vector<size_t> &slots) {
+  const int *table = _table.data();
+  const int *ops = _ops.data();
+  int s = _start;
+
+  if (_start_ops >= 0) {
+    apply(_start_ops, pos);
+  }
+
+  for (size_t p = pos; p < str.length(); p++) {
+    int t = s * _stride + _symbol[(unsigned char)str[p]];
+    s = table[t];
+    if (s == DEAD) {
+      return false;
+    }
+    if (ops[t] >= 0) {
+      apply(ops[t], p + 1);
+    }
+  }
+
+  if (_final[s] < 0) {
+    return false;
+  }
+
+  const int *final = _code.data() + _final[s];
+  slots.resize(_slots);
+  for (int i = 0; i < _slots; i++) {
+    slots[i] = final[i] < 0 ? std::string_view::npos : _regs[final[i]];
+  }
+  slots[0] = pos;
+  slots[1] = str.length();
+  return true;
+}
+
+// the number of states
+size_t Tdfa::state_count() const { return _final.size(); }
+
+// the number of registers
+int Tdfa::register_count() const { return _registers; }
+
+// Run the operations at index op of _code. Every new register is computed
+// from the old ones before any is replaced.
+void Tdfa::apply(int op, size_t pos) {
+  const int *code = _code.data() + op;
+  int n = code[0];
+
+  for (int k = 0; k < n; k++) {
+    int source = code[k + 1];
+    _next[k] = source < 0 ? pos : _regs[source];
+  }
+  std::swap(_regs, _next);
+}
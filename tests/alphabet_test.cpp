@@ -0,0 +1,97 @@
+// File: tests/alphabet_test.cpp
+// Purpose: Check that the byte equivalence classes of a program group
+//          exactly the bytes every instruction treats alike, and that the
+//          DFAs indexing their tables by class agree with the Pike VM on
+//          inputs drawn from every byte.
+// Author: Robert Lowe
+#include "dfa.h"
+#include "lazy_dfa.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// return true if every instruction consumes both a and b or neither
+static bool alike(const Program *program, int a, int b) {
+  for (int pc = 0; pc < program->size(); pc++) {
+    if (program->consumes(pc, a) != program->consumes(pc, b)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// a random pattern whose atoms split the bytes in many ways
+static std::string random_bytes_pattern(std::mt19937 &rng) {
+  static const char *atoms[] = {"a",     "[a-f]", "[^a-c]", ".",
+                                "[0-9]", "\\.",   "[d-z]",  "[xy]"};
+  std::string result;
+
+  for (int n = 1 + rng() % 5; n > 0; n--) {
+    result += atoms[rng() % 8];
+    int q = rng() % 4;
+    if (q == 0) {
+      result += "*";
+    } else if (q == 1) {
+      result += "+";
+    } else if (q == 2 && n > 1) {
+      result += "|";
+    }
+  }
+  return result;
+}
+
+int main() {
+  std::mt19937 rng(8);
+  std::string bytes;
+  for (int c = 0; c < 256; c++) {
+    bytes += (char)c;
+  }
+  bytes += "aaabbcdz0.";
+
+  for (int i = 0; i < 1000; i++) {
+    std::string pattern =
+        i % 2 ? random_pattern(rng) : random_bytes_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+
+    // bytes share a class exactly when no instruction tells them apart
+    bool ok = true;
+    for (int a = 0; a < 256; a++) {
+      int sym = program->symbol(a);
+      ok = ok && sym < program->alphabet_size() &&
+           program->symbol(program->representative(sym)) == sym;
+      for (int b = a + 1; b < 256 && ok; b++) {
+        ok = (program->symbol(b) == sym) == alike(program, a, b);
+      }
+    }
+    check(ok, "classes of " + pattern);
+
+    PikeVM vm(program);
+    Dfa *dfa = Dfa::build(program);
+    LazyDfa lazy(program);
+    for (int j = 0; j < 20; j++) {
+      std::string s = random_input(rng, 20, bytes);
+      size_t pos = rng() % (s.length() + 1);
+      std::string what = pattern + " at " + std::to_string(pos);
+
+      size_t end = 0, expected_end = 0;
+      bool expected = vm.match(s, pos, expected_end);
+      bool matched = lazy.match(s, pos, end);
+      check(matched == expected && (!matched || end == expected_end),
+            "lazy dfa " + what);
+      if (dfa) {
+        matched = dfa->match(s, pos, end);
+        check(matched == expected && (!matched || end == expected_end),
+              "dfa " + what);
+      }
+    }
+    delete dfa;
+    delete program;
+  }
+
+  return report("alphabet_test");
+}
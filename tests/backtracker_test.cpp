@@ -0,0 +1,79 @@
+// File: tests/backtracker_test.cpp
+// Purpose: Check the backtracker against the Pike VM, including the
+//          capture slots of each match, with a budget large enough for the
+//          inputs and with one far too small.
+// Author: Robert Lowe
+#include "backtracker.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// check that every group lies within the match, or took no part in it
+static bool within(const std::vector<size_t> &slots) {
+  for (size_t i = 2; i < slots.size(); i += 2) {
+    bool unset = slots[i] == std::string::npos &&
+                 slots[i + 1] == std::string::npos;
+    if (!unset && !(slots[0] <= slots[i] && slots[i] <= slots[i + 1] &&
+                    slots[i + 1] <= slots[1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// compare the backtracker with the vm on random inputs
+static void compare(const std::string &pattern, Program *program,
+                    size_t budget, std::mt19937 &rng) {
+  PikeVM vm(program);
+  Backtracker bt(program, budget);
+
+  for (int j = 0; j < 20; j++) {
+    std::string s = random_input(rng, 12);
+    size_t pos = rng() % (s.length() + 1);
+    std::string what = pattern + " (" + std::to_string(budget) +
+                       " bytes) on '" + s + "' at " + std::to_string(pos);
+
+    size_t end = 0, expected_end = 0;
+    int id = -1, expected_id = -1;
+    bool matched = bt.match(s, pos, end, id);
+    bool expected = vm.match(s, pos, expected_end, expected_id);
+    check(matched == expected &&
+              (!matched || (end == expected_end && id == expected_id)),
+          "match " + what);
+
+    size_t start = 0, expected_start = 0;
+    matched = bt.search(s, pos, start, end);
+    expected = vm.search(s, pos, expected_start, expected_end);
+    check(matched == expected &&
+              (!matched || (start == expected_start && end == expected_end)),
+          "search " + what);
+
+    std::vector<size_t> slots, expected_slots;
+    matched = bt.match(s, pos, slots);
+    expected = vm.match(s, pos, expected_slots);
+    check(matched == expected && (!matched || slots == expected_slots),
+          "captures " + what);
+    check(!matched || within(slots), "groups within the match " + what);
+  }
+}
+
+int main() {
+  std::mt19937 rng(7);
+
+  for (int i = 0; i < 1500; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    parser.captures(true);
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+
+    compare(pattern, program, Backtracker::DEFAULT_BUDGET_BYTES, rng);
+    compare(pattern, program, 1, rng);
+    delete program;
+  }
+
+  return report("backtracker_test");
+}
@@ -0,0 +1,95 @@
+// File: tests/class_node_test.cpp
+// Purpose: Check the vector span of a ClassNode against testing one byte
+//          at a time, on runs longer than a block and runs ending inside
+//          one, and the quantifiers which skip runs with it against the
+//          reference matcher.
+// Author: Robert Lowe
+#include "class_node.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// a random class of up to six ranges, so that some have too many for the
+// vector loop
+static ByteSet random_class(std::mt19937 &rng) {
+  ByteSet set;
+  int ranges = 1 + rng() % 6;
+
+  for (int r = 0; r < ranges; r++) {
+    int lo = rng() % 256;
+    int hi = std::min(255, lo + (int)(rng() % 20));
+    set.add_range(lo, hi);
+  }
+  if (rng() % 4 == 0) {
+    set.invert();
+  }
+  return set;
+}
+
+// a byte of the set, or of its complement
+static char pick(std::mt19937 &rng, const ByteSet &set, bool in) {
+  for (;;) {
+    int c = rng() % 256;
+    if (set.contains(c) == in) {
+      return c;
+    }
+  }
+}
+
+int main() {
+  std::mt19937 rng(7);
+
+  for (int i = 0; i < 3000; i++) {
+    ByteSet set = random_class(rng);
+    if (set.count() == 0 || set.full()) {
+      continue;
+    }
+    ClassNode node(set);
+
+    for (int j = 0; j < 20; j++) {
+      // a run of up to 100 bytes, then maybe a byte out of the class and
+      // some more of either, at any alignment
+      size_t offset = rng() % 16;
+      size_t run = rng() % 101;
+      std::string s(offset, 'x');
+      for (size_t k = 0; k < run; k++) {
+        s += pick(rng, set, true);
+      }
+      if (rng() % 4) {
+        s += pick(rng, set, false);
+        for (int k = rng() % 40; k > 0; k--) {
+          s += pick(rng, set, rng() % 2);
+        }
+      }
+
+      size_t n = s.length() - offset;
+      size_t expected = 0;
+      while (expected < n && set.contains(s[offset + expected])) {
+        expected++;
+      }
+      check(node.span(s.data() + offset, n) == expected,
+            "span of a run of " + std::to_string(run) + " at offset " +
+                std::to_string(offset));
+    }
+  }
+
+  // the quantifiers of a class skip whole runs with the span
+  const char *patterns[] = {"[a-f]*", "[a-f]+", "x[0-9a-f]+y", "[^x]*x",
+                            "[ab]+c", "([a-c]+)*"};
+  for (auto pattern : patterns) {
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    for (int j = 0; j < 300; j++) {
+      std::string s = random_input(rng, 80, "aaaabbbbccdefx0y");
+      size_t pos = rng() % (s.length() + 1);
+      size_t end = pos, expected_end = 0;
+      bool matched = tree->match(s, end);
+      bool expected = reference_match(tree, s, pos, expected_end);
+      check(matched == expected && (!matched || end == expected_end),
+            std::string(pattern) + " on '" + s + "' at " +
+                std::to_string(pos));
+    }
+    delete tree;
+  }
+
+  return report("class_node_test");
+}
@@ -0,0 +1,92 @@
+// File: tests/dfa_test.cpp
+// Purpose: Check the minimized DFA against the Pike VM, with one root and
+//          with several.
+// Author: Robert Lowe
+#include "dfa.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// compare the dfa with the vm on random inputs
+static void compare(const std::string &pattern, Program *program,
+                    std::mt19937 &rng) {
+  PikeVM vm(program);
+  Dfa *dfa = Dfa::build(program);
+  check(dfa, "build " + pattern);
+  if (!dfa) {
+    return;
+  }
+
+  for (int j = 0; j < 20; j++) {
+    std::string s = random_input(rng, 12);
+    size_t pos = rng() % (s.length() + 1);
+    std::string what = pattern + " on '" + s + "' at " + std::to_string(pos);
+
+    size_t end = 0, expected_end = 0;
+    int id = -1, expected_id = -1;
+    bool matched = dfa->match(s, pos, end, id);
+    bool expected = vm.match(s, pos, expected_end, expected_id);
+    check(matched == expected &&
+              (!matched || (end == expected_end && id == expected_id)),
+          "match " + what);
+
+    size_t start = 0, expected_start = 0;
+    matched = dfa->search(s, pos, start, end);
+    expected = vm.search(s, pos, expected_start, expected_end);
+    check(matched == expected &&
+              (!matched || (start == expected_start && end == expected_end)),
+          "search " + what);
+  }
+
+  delete dfa;
+}
+
+int main() {
+  std::mt19937 rng(3);
+
+  for (int i = 0; i < 1500; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+
+    compare(pattern, program, rng);
+    delete program;
+  }
+
+  // several roots, where the ids decide between them
+  for (int i = 0; i < 500; i++) {
+    std::vector<RegexNode *> roots;
+    std::string pattern;
+    RegexParser parser;
+    for (int k = 0; k < 3; k++) {
+      std::string root = random_pattern(rng);
+      roots.push_back(parser.parse(root));
+      pattern += (k ? ", " : "") + root;
+    }
+    NfaCompiler compiler;
+    Program *program = compiler.compile(roots);
+    for (auto root : roots) {
+      delete root;
+    }
+
+    compare(pattern, program, rng);
+    delete program;
+  }
+
+  // a dfa bigger than its state limit is not built
+  RegexParser parser;
+  RegexNode *tree = parser.parse("(a|b)*a(a|b)(a|b)(a|b)(a|b)");
+  NfaCompiler compiler;
+  Program *program = compiler.compile(tree);
+  delete tree;
+  Dfa *dfa = Dfa::build(program, 8);
+  check(!dfa, "build past the state limit");
+  delete dfa;
+  delete program;
+
+  return report("dfa_test");
+}
@@ -0,0 +1,80 @@
+// File: tests/flat_regex_test.cpp
+// Purpose: Check that a FlatRegex matches and searches exactly as the tree
+//          it was flattened from, greedy choices and all, on alternatives,
+//          classes and quantifiers.
+// Author: Robert Lowe
+#include "flat_regex.h"
+#include "lib.h"
+#include "test_util.h"
+
+// Compare the tree and the flat regex of the pattern on random inputs,
+// returning false if the tree might not finish, or the pattern does not
+// flatten.
+static bool compare(const std::string &pattern, std::mt19937 &rng,
+                    size_t length, const std::string &alphabet) {
+  RegexNode *tree = make_regex(pattern, REGEX_TREE);
+  if (!tree || !terminates(tree)) {
+    delete tree;
+    return false;
+  }
+  FlatRegex *flat = dynamic_cast<FlatRegex *>(make_regex(pattern, REGEX_FLAT));
+  check(flat, "flatten " + pattern);
+  if (!flat) {
+    delete tree;
+    return false;
+  }
+
+  for (int j = 0; j < 20; j++) {
+    std::string s = random_input(rng, length, alphabet);
+    size_t start = rng() % (s.length() + 1);
+
+    size_t a = start, b = start, c = start;
+    bool matched = tree->match(s, a);
+    check(flat->match(s, b) == matched && (!matched || a == b),
+          "match " + pattern + " in '" + s + "' at " + std::to_string(start));
+    check(flat->match(std::string_view(s), c) == matched &&
+              (!matched || a == c),
+          "match a view of '" + s + "' with " + pattern);
+
+    size_t tree_start, tree_end, flat_start, flat_end;
+    bool found = tree->search(s, start, tree_start, tree_end);
+    check(flat->search(s, start, flat_start, flat_end) == found &&
+              (!found || (tree_start == flat_start && tree_end == flat_end)),
+          "search " + pattern + " in '" + s + "' from " +
+              std::to_string(start));
+  }
+
+  delete tree;
+  delete flat;
+  return true;
+}
+
+int main() {
+  std::mt19937 rng(15);
+
+  // random patterns, as many as the tree can finish
+  int compared = 0;
+  for (int i = 0; i < 3000; i++) {
+    compared += compare(random_pattern(rng), rng, 16, "abcx.");
+  }
+  check(compared > 1000, "enough patterns compared");
+
+  // The tree takes the first alternative which matches, and quantifiers
+  // take all they can without giving any back, so some of these match
+  // less than they could or not at all
+  const char *patterns[] = {"ab|abc",  "(a|ab)c",   "x(ab|a)*b",
+                            "[a-c]+c", "[^a]*a",    "[0-9a-f]+x",
+                            "a+b?c*",  "(ab)+a",    "((a|b)c)*x",
+                            "[^x]|xa", "a(b|c|x)+", "\\.+[ab]?",
+                            "(a?b)+",  "x*(a|bc)?x", "[a-cx]*(ab)+"};
+  for (auto pattern : patterns) {
+    check(compare(pattern, rng, 40, "abcx.0f"), pattern);
+  }
+
+  // searches through long inputs with matches far apart
+  for (auto pattern : {"x[0-9]+y", "(ab|cd)+e", "[^a-w]x"}) {
+    check(compare(pattern, rng, 3000, "aaaaaaaaabcdex0189y"), pattern);
+  }
+
+  return report("flat_regex_test");
+}
@@ -0,0 +1,76 @@
+// File: tests/incremental_lexer_test.cpp
+// Purpose: Check the tokens an incremental lexer keeps against lexing the
+//          whole text again, after each of a long run of random edits.
+// Author: Robert Lowe
+#include "incremental_lexer.h"
+#include "lib.h"
+#include "test_util.h"
+
+// A pattern the lexer cannot compile, which it falls back on matching as a
+// tree and treats as examining the rest of the input
+class PairNode : public RegexNode {
+public:
+  virtual bool match(const std::string &str, size_t &pos) {
+    if (str.compare(pos, 2, "zz") != 0) {
+      return false;
+    }
+    pos += 2;
+    return true;
+  }
+};
+
+// Give the lexer tokens which need lookahead beyond their lexemes
+static void add_tokens(Lexer &lexer, bool tree) {
+  lexer.add_token(1, make_regex("[a-c]+", REGEX_NFA));
+  lexer.add_token(2, make_regex("ab|abcd", REGEX_NFA));
+  lexer.add_token(3, make_regex("\"[^\"]*\"", REGEX_NFA));
+  lexer.add_token(4, make_regex(" +", REGEX_NFA));
+  if (tree) {
+    lexer.add_token(5, new PairNode());
+  }
+}
+
+int main() {
+  std::mt19937 rng(5);
+
+  for (int tree = 0; tree < 2; tree++) {
+    Lexer lexer, full;
+    add_tokens(lexer, tree);
+    add_tokens(full, tree);
+    IncrementalLexer incremental(lexer);
+    incremental.input("");
+
+    for (int i = 0; i < 20000; i++) {
+      // grow the text to a few hundred bytes, then hold it there
+      size_t offset = rng() % (incremental.text().length() + 1);
+      size_t removed = rng() % 3;
+      std::string inserted = random_input(rng, 4, "abcd \"zx");
+      if (incremental.text().length() > 300) {
+        removed = 10;
+        inserted.clear();
+      }
+      incremental.edit(offset, removed, inserted);
+
+      full.input(incremental.text());
+      size_t n = 0;
+      bool same = true;
+      for (Lexer::TokenView t = full.next_view();
+           t.tok != Lexer::END_OF_INPUT; t = full.next_view(), n++) {
+        if (n >= incremental.size() || incremental.tok(n) != t.tok ||
+            incremental.pos(n) != t.pos ||
+            incremental.len(n) != t.lexeme.length()) {
+          same = false;
+          break;
+        }
+      }
+      check(same && n == incremental.size(),
+            "edit " + std::to_string(i) + " giving '" + incremental.text() +
+                "'");
+      check(incremental.changed_begin() <= incremental.changed_end() &&
+                incremental.changed_end() <= incremental.size(),
+            "changed range after edit " + std::to_string(i));
+    }
+  }
+
+  return report("incremental_lexer_test");
+}
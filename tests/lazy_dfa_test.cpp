@@ -0,0 +1,77 @@
+// File: tests/lazy_dfa_test.cpp
+// Purpose: Check the lazy DFA against the Pike VM, with caches small enough
+//          to be cleared in the middle of a match.
+// Author: Robert Lowe
+#include "lazy_dfa.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// Compare the dfa with the vm on random inputs, returning the number of
+// times the dfa's cache was cleared.
+static size_t compare(const std::string &pattern, Program *program,
+                      size_t cache_bytes, std::mt19937 &rng, size_t length) {
+  PikeVM vm(program);
+  LazyDfa dfa(program, cache_bytes);
+
+  for (int j = 0; j < 40; j++) {
+    std::string s = random_input(rng, length);
+    size_t pos = rng() % (s.length() + 1);
+    std::string what = pattern + " (" + std::to_string(cache_bytes) +
+                       " bytes) on '" + s + "' at " + std::to_string(pos);
+
+    size_t end = 0, expected_end = 0;
+    int id = -1, expected_id = -1;
+    bool matched = dfa.match(s, pos, end, id);
+    bool expected = vm.match(s, pos, expected_end, expected_id);
+    check(matched == expected &&
+              (!matched || (end == expected_end && id == expected_id)),
+          "match " + what);
+    check(dfa.examined() == vm.examined(), "examined " + what);
+
+    size_t start = 0, expected_start = 0;
+    matched = dfa.search(s, pos, start, end);
+    expected = vm.search(s, pos, expected_start, expected_end);
+    check(matched == expected &&
+              (!matched || (start == expected_start && end == expected_end)),
+          "search " + what);
+  }
+
+  return dfa.stats().clears;
+}
+
+int main() {
+  std::mt19937 rng(2);
+  const size_t caches[] = {LazyDfa::DEFAULT_CACHE_BYTES, 3500, 1500};
+  size_t clears = 0;
+
+  for (int i = 0; i < 1500; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+
+    for (auto cache_bytes : caches) {
+      clears += compare(pattern, program, cache_bytes, rng, 16);
+    }
+    delete program;
+  }
+
+  // a pattern whose dfa is far bigger than the cache
+  std::string pattern = "(a|b)*a(a|b)(a|b)(a|b)c";
+  RegexParser parser;
+  RegexNode *tree = parser.parse(pattern);
+  NfaCompiler compiler;
+  Program *program = compiler.compile(tree);
+  delete tree;
+  for (int i = 0; i < 100; i++) {
+    clears += compare(pattern, program, 3500, rng, 24);
+  }
+  delete program;
+
+  check(clears > 0, "the cache was never cleared");
+  return report("lazy_dfa_test");
+}
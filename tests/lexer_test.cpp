@@ -0,0 +1,236 @@
+// File: tests/lexer_test.cpp
+// Purpose: Check the tokens of a Lexer scanning with its combined
+//          automaton against the longest match of each pattern by the
+//          reference matcher, and against the lexer's own path of matching
+//          one tree at a time.
+// Author: Robert Lowe
+#include "dfa.h"
+#include "lexer.h"
+#include "lib.h"
+#include "nfa_compiler.h"
+#include "regex_parser.h"
+#include "test_util.h"
+#include <tuple>
+
+// A pattern the lexer cannot compile, which sends it down the tree path.
+// It never matches, so the other patterns decide every token.
+class NeverNode : public RegexNode {
+public:
+  virtual bool match(const std::string &, size_t &) { return false; }
+};
+
+// A custom pattern matching zz, which says nothing of its first bytes
+class PairNode : public RegexNode {
+public:
+  virtual bool match(const std::string &str, size_t &pos) {
+    if (str.compare(pos, 2, "zz") != 0) {
+      return false;
+    }
+    pos += 2;
+    return true;
+  }
+};
+
+// A token as a comparable tuple: its numeric token, position and lexeme
+typedef std::vector<std::tuple<int, size_t, std::string>> Tokens;
+
+// lex the whole input
+static Tokens lex(Lexer &lexer) {
+  Tokens result;
+  for (Lexer::Token t = lexer.next(); t.tok != Lexer::END_OF_INPUT;
+       t = lexer.next()) {
+    result.push_back(std::make_tuple(t.tok, t.pos, t.lexeme));
+  }
+  return result;
+}
+
+// The tokens of s by the lexer's rule: the longest non-empty match of any
+// pattern, the first added winning ties, and where nothing matches one
+// invalid byte. Pattern i is token i + 1.
+static Tokens reference_lex(const std::vector<RegexNode *> &trees,
+                            const std::string &s) {
+  Tokens result;
+
+  for (size_t pos = 0; pos < s.length();) {
+    int tok = Lexer::INVALID;
+    size_t best = pos + 1;
+    for (size_t i = 0; i < trees.size(); i++) {
+      size_t end;
+      if (reference_match(trees[i], s, pos, end) && end > pos &&
+          (tok == Lexer::INVALID || end > best)) {
+        tok = i + 1;
+        best = end;
+      }
+    }
+    result.push_back(std::make_tuple(tok, pos, s.substr(pos, best - pos)));
+    pos = best;
+  }
+
+  return result;
+}
+
+// Lex random inputs with the patterns, comparing the combined automaton
+// with the reference.
+static void compare_reference(const std::vector<std::string> &patterns,
+                              std::mt19937 &rng, size_t length,
+                              const std::string &alphabet) {
+  std::vector<RegexNode *> trees;
+  Lexer lexer;
+  for (size_t i = 0; i < patterns.size(); i++) {
+    RegexParser parser;
+    trees.push_back(parser.parse(patterns[i]));
+    lexer.add_token(i + 1, make_regex(patterns[i], REGEX_TREE));
+  }
+
+  std::string what;
+  for (auto &pattern : patterns) {
+    what += " " + pattern;
+  }
+  for (int j = 0; j < 20; j++) {
+    std::string s = random_input(rng, length, alphabet);
+    lexer.input(s);
+    check(lex(lexer) == reference_lex(trees, s),
+          "tokens of" + what + " in '" + s + "'");
+  }
+
+  for (auto tree : trees) {
+    delete tree;
+  }
+}
+
+// Token patterns of the usual sort, which the trees match greedily just as
+// the automaton matches longest: keywords before identifiers, numbers,
+// strings, operators and spaces.
+static const char *token_patterns[] = {
+    "if", "[a-z_][a-z0-9_]*", "[0-9]+", "[0-9]+\\.[0-9]+", "\"[^\"]*\"",
+    "==", "=", " +", "\\(", "\\)"};
+
+// add the usual tokens to a lexer, and a tree pattern to force the tree
+// path if tree is set
+static void add_tokens(Lexer &lexer, bool tree) {
+  int tok = 1;
+  for (auto pattern : token_patterns) {
+    lexer.add_token(tok++, make_regex(pattern, REGEX_TREE));
+  }
+  if (tree) {
+    lexer.add_token(tok, new NeverNode());
+  }
+}
+
+int main() {
+  std::mt19937 rng(9);
+
+  // random patterns, some matching the empty string, some tying
+  for (int i = 0; i < 1000; i++) {
+    std::vector<std::string> patterns;
+    for (int k = 1 + rng() % 4; k > 0; k--) {
+      patterns.push_back(random_pattern(rng));
+    }
+    compare_reference(patterns, rng, 16, "abcx.");
+  }
+
+  // ties go to the first pattern added, empty matches are no token, and
+  // bytes no pattern begins with are invalid
+  compare_reference({"if", "[a-z]+", "i[a-z]", "x*"}, rng, 30, "ifxyz!");
+  compare_reference({"a*", "b?", "(cd)*"}, rng, 30, "abcde");
+
+  // the first bytes of each pattern come from a class, past an optional or
+  // repeated prefix, or from either side of an alternative
+  compare_reference({"[0-9]x", "a?b", "x*y", "(c)|(d)e", "[^a-e]"}, rng, 30,
+                    "0x9abcdexy!");
+
+  // a custom pattern which cannot say what it begins with may begin with
+  // anything
+  Lexer custom;
+  custom.add_token(1, make_regex("[a-y]+", REGEX_TREE));
+  custom.add_token(2, new PairNode());
+  custom.input("abzzazb");
+  Tokens expected = {std::make_tuple(1, 0, "ab"), std::make_tuple(2, 2, "zz"),
+                     std::make_tuple(1, 4, "a"),
+                     std::make_tuple((int)Lexer::INVALID, 5, "z"),
+                     std::make_tuple(1, 6, "b")};
+  check(lex(custom) == expected, "custom pattern");
+
+  // the automaton agrees with the lexer's tree path
+  Lexer automaton, trees;
+  add_tokens(automaton, false);
+  add_tokens(trees, true);
+  for (int j = 0; j < 300; j++) {
+    std::string s = random_input(rng, 80, "ifx_9.0\"= ()\t");
+    automaton.input(s);
+    trees.input(s);
+    check(lex(automaton) == lex(trees), "tree path on '" + s + "'");
+  }
+
+  // A pattern set whose full DFA is too big, so the lexer falls back on a
+  // lazy one
+  std::vector<std::string> big = {"(a|b)*a(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)"
+                                  "(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)(a|b)",
+                                  "b+", "a"};
+  std::vector<RegexNode *> roots;
+  for (auto &pattern : big) {
+    RegexParser parser;
+    roots.push_back(parser.parse(pattern));
+  }
+  NfaCompiler compiler;
+  Program *program = compiler.compile(roots);
+  Dfa *dfa = Dfa::build(program);
+  check(!dfa, "the big pattern set builds a full dfa");
+  delete dfa;
+  delete program;
+  for (auto root : roots) {
+    delete root;
+  }
+  compare_reference(big, rng, 40, "ab");
+
+  // A borrowed buffer gives the same tokens, whose lexemes point into it.
+  // A lexer with a tree pattern will not borrow, and copies the input.
+  for (int j = 0; j < 100; j++) {
+    std::string s = random_input(rng, 80, "ifx_9.0\"= ()\t");
+    automaton.input(s);
+    Tokens copied = lex(automaton);
+
+    check(automaton.borrow(s), "borrow");
+    Tokens borrowed;
+    bool inside = true;
+    for (Lexer::TokenView t = automaton.next_view();
+         t.tok != Lexer::END_OF_INPUT; t = automaton.next_view()) {
+      borrowed.push_back(
+          std::make_tuple(t.tok, t.pos, std::string(t.lexeme)));
+      inside = inside && t.lexeme.data() == s.data() + t.pos;
+    }
+    check(borrowed == copied && inside, "borrowed '" + s + "'");
+
+    check(!trees.borrow(s) && trees.at_end(), "borrow with a tree pattern");
+    trees.input(s);
+    check(lex(trees) == copied, "copied '" + s + "'");
+  }
+
+  // Batches hold the tokens next() returns, the last one stopping short at
+  // the end of the input, after which there are none
+  for (int j = 0; j < 300; j++) {
+    std::string s = random_input(rng, 60, "ifx_9.0\"= ()\t");
+    size_t max = 1 + j % 5;
+    automaton.input(s);
+    Tokens expected = lex(automaton);
+
+    automaton.input(s);
+    Tokens batched;
+    int tok[5];
+    size_t pos[5], len[5], count, last = max;
+    while ((count = automaton.next_batch(tok, pos, len, max)) > 0) {
+      check(last == max, "a batch short of the end of '" + s + "'");
+      for (size_t i = 0; i < count; i++) {
+        batched.push_back(
+            std::make_tuple(tok[i], pos[i], s.substr(pos[i], len[i])));
+      }
+      last = count;
+    }
+    check(batched == expected && automaton.at_end(),
+          "batches of " + std::to_string(max) + " in '" + s + "'");
+    check(automaton.next_batch(tok, pos, len, max) == 0,
+          "a batch after the end");
+  }
+
+  return report("lexer_test");
+}
@@ -0,0 +1,101 @@
+// File: tests/line_index_test.cpp
+// Purpose: Check the lines and columns a LineIndex and a Lexer report
+//          against counting newlines, and the location of parse errors.
+// Author: Robert Lowe
+#include <sstream>
+#include "lexer.h"
+#include "line_index.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// count the lines and columns up to offset
+static void naive_locate(const std::string &text, size_t offset, size_t &line,
+                         size_t &column) {
+  line = column = 1;
+  for (size_t p = 0; p < offset; p++) {
+    if (text[p] == '\n') {
+      line++;
+      column = 1;
+    } else {
+      column++;
+    }
+  }
+}
+
+// return true if the index and the naive count agree at offset
+static bool agree(LineIndex &index, const std::string &text, size_t offset) {
+  size_t line, column, expected_line, expected_column;
+  index.locate(text, offset, line, column);
+  naive_locate(text, offset, expected_line, expected_column);
+  return line == expected_line && column == expected_column;
+}
+
+// the error message of parsing the pattern
+static std::string parse_error(const std::string &pattern) {
+  std::ostringstream out;
+  std::streambuf *saved = std::cerr.rdbuf(out.rdbuf());
+  RegexParser parser;
+  delete parser.parse(pattern);
+  std::cerr.rdbuf(saved);
+  return out.str();
+}
+
+int main() {
+  std::mt19937 rng(12);
+  LineIndex index;
+
+  // offsets in any order, at the start and the end, in texts with CRLF
+  // line ends, with and without a final newline
+  for (int i = 0; i < 500; i++) {
+    std::string text = random_input(rng, 300, "ab\n\r");
+    if (i % 2 && !text.empty() && text.back() == '\n') {
+      text.pop_back();
+    }
+    index.reset();
+    check(agree(index, text, 0), "offset 0");
+    for (int j = 0; j < 20; j++) {
+      size_t offset = rng() % (text.length() + 1);
+      check(agree(index, text, offset),
+            "offset " + std::to_string(offset) + " in text " +
+                std::to_string(i));
+    }
+    check(agree(index, text, text.length()), "the end of text " +
+                                                 std::to_string(i));
+  }
+
+  // a text which grows between lookups
+  index.reset();
+  std::string text;
+  for (int i = 0; i < 200; i++) {
+    text += random_input(rng, 40, "ab\n");
+    check(agree(index, text, rng() % (text.length() + 1)),
+          "growing text " + std::to_string(i));
+  }
+
+  // the lexer's index is rebuilt for each input
+  Lexer lexer("one\r\ntwo\nthree");
+  size_t line, column;
+  lexer.location(0, line, column);
+  check(line == 1 && column == 1, "lexer at 0");
+  lexer.location(4, line, column);
+  check(line == 1 && column == 5, "lexer at the CRLF's newline");
+  lexer.location(13, line, column);
+  check(line == 3 && column == 5, "lexer at the last byte");
+  lexer.location(14, line, column);
+  check(line == 3 && column == 6, "lexer at the end");
+  lexer.input("a\n\nb\n");
+  lexer.location(3, line, column);
+  check(line == 3 && column == 1, "lexer after new input");
+  lexer.location(5, line, column);
+  check(line == 4 && column == 1, "lexer at the end of new input");
+
+  // parse errors give the line and column of the token
+  check(parse_error("(ab") == "Expected ) at line 1, column 4\n",
+        "error in (ab");
+  check(parse_error("a**") == "Unexpected token at line 1, column 3\n",
+        "error in a**");
+  check(parse_error("a\nb\n(c") == "Expected ) at line 3, column 3\n",
+        "error on the third line");
+
+  return report("line_index_test");
+}
@@ -0,0 +1,114 @@
+// File: tests/line_scanner_test.cpp
+// Purpose: Check the literals the analysis requires against the matches of
+//          the reference matcher, the vector literal search against
+//          std::string_view::find, and the lines a LineScanner finds
+//          against searching every line.
+// Author: Robert Lowe
+#include "line_scanner.h"
+#include "literal_analysis.h"
+#include "literal_scanner.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// return true if s begins with, ends with or contains text
+static bool begins(const std::string &s, const std::string &text) {
+  return s.compare(0, text.length(), text) == 0;
+}
+static bool ends(const std::string &s, const std::string &text) {
+  return s.length() >= text.length() &&
+         s.compare(s.length() - text.length(), text.length(), text) == 0;
+}
+static bool contains(const std::string &s, const std::string &text) {
+  return s.find(text) != std::string::npos;
+}
+
+// count the lines of buf with a match by searching each one
+static size_t naive_count(const std::string &pattern, const std::string &buf) {
+  RegexNode *regex = make_regex(pattern, REGEX_NFA);
+  size_t count = 0, start, end;
+
+  for (size_t pos = 0; pos < buf.length();) {
+    size_t nl = buf.find('\n', pos);
+    if (nl == std::string::npos) {
+      nl = buf.length();
+    }
+    count += regex->search(buf.substr(pos, nl - pos), 0, start, end);
+    pos = nl + 1;
+  }
+
+  delete regex;
+  return count;
+}
+
+int main() {
+  std::mt19937 rng(6);
+
+  // the literals every match must contain
+  const char *cases[][2] = {{".*ERROR[0-9]+", "ERROR"},
+                            {"abc", "abc"},
+                            {"[0-9]+ms", "ms"},
+                            {"x(abc)|(abd)y", "xab"},
+                            {"a*b*", ""}};
+  for (auto &c : cases) {
+    RegexParser parser;
+    RegexNode *tree = parser.parse(c[0]);
+    check(required_literal(tree) == c[1],
+          std::string("literal of ") + c[0] + " is '" +
+              required_literal(tree) + "'");
+    delete tree;
+  }
+
+  // every match holds the prefix, suffix and required literal
+  for (int i = 0; i < 2000; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    LiteralInfo info = analyze_literals(tree);
+
+    for (int j = 0; j < 20; j++) {
+      std::string s = random_input(rng, 12);
+      size_t pos = rng() % (s.length() + 1), end;
+      if (!reference_match(tree, s, pos, end)) {
+        continue;
+      }
+      std::string m = s.substr(pos, end - pos);
+      check((!info.exact || m == info.str) && begins(m, info.prefix) &&
+                ends(m, info.suffix) && contains(m, info.required),
+            "literals of " + pattern + " in '" + m + "'");
+    }
+    delete tree;
+  }
+
+  // Literals at every offset across several 16 and 32 byte blocks, in
+  // haystacks full of near misses
+  for (int i = 0; i < 20000; i++) {
+    std::string literal = random_input(rng, 40, "ab");
+    if (literal.empty()) {
+      literal = "b";
+    }
+    std::string s = random_input(rng, 160, "ab");
+    if (rng() % 2) {
+      s.insert(rng() % (s.length() + 1), literal);
+    }
+    size_t pos = rng() % (s.length() + 2);
+
+    LiteralScanner scanner(literal);
+    size_t expected = std::string_view(s).find(literal, pos);
+    check(scanner.find(s, pos) == expected,
+          "find '" + literal + "' in '" + s + "' from " + std::to_string(pos));
+  }
+
+  // the scanned lines are those a search of every line finds
+  const char *patterns[] = {".*ERROR[0-9]+", "ab+c", "x|y", "a*", "b.a",
+                            "q"};
+  for (auto pattern : patterns) {
+    LineScanner scanner(pattern);
+    for (int j = 0; j < 200; j++) {
+      std::string buf = random_input(rng, 400, "abcxyERROR019\n");
+      check(scanner.count(buf) == naive_count(pattern, buf),
+            std::string("lines of ") + pattern + " in '" + buf + "'");
+    }
+  }
+
+  return report("line_scanner_test");
+}
@@ -0,0 +1,100 @@
+// File: tests/mapped_file_test.cpp
+// Purpose: Check that a Lexer and a LineScanner given a file mapped into
+//          memory find what they find in its contents read into a string,
+//          including for an empty file, and that a missing file is refused.
+// Author: Robert Lowe
+#include <cstdio>
+#include <unistd.h>
+#include "lexer.h"
+#include "line_scanner.h"
+#include "mapped_file.h"
+#include "test_util.h"
+
+// write contents to a new temporary file, returning its path
+static std::string temp_file(const std::string &contents) {
+  char path[] = "/tmp/mapped_file_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0 || write(fd, contents.data(), contents.length()) !=
+                    (ssize_t)contents.length()) {
+    check(false, "write a temporary file");
+  }
+  close(fd);
+  return path;
+}
+
+// a pattern which cannot be compiled, so it can only scan a copy
+class NeverNode : public RegexNode {
+public:
+  virtual bool match(const std::string &, size_t &) { return false; }
+};
+
+// add the tokens of a small language to the lexer
+static void add_tokens(Lexer &lexer) {
+  lexer.add_token(1, make_regex("[a-z]+", REGEX_TREE));
+  lexer.add_token(2, make_regex("[0-9]+", REGEX_TREE));
+  lexer.add_token(3, make_regex("[ \n]+", REGEX_TREE));
+}
+
+// return true if the lexer produces the same tokens as one given contents
+static bool same_tokens(Lexer &lexer, const std::string &contents) {
+  Lexer expected(contents);
+  add_tokens(expected);
+
+  for (;;) {
+    Lexer::Token a = lexer.next(), b = expected.next();
+    if (a.tok != b.tok || a.pos != b.pos || a.lexeme != b.lexeme) {
+      return false;
+    }
+    if (a.tok == Lexer::END_OF_INPUT) {
+      return true;
+    }
+  }
+}
+
+int main() {
+  std::mt19937 rng(10);
+  const std::string missing = "/tmp/mapped_file_test_missing";
+  unlink(missing.c_str());
+
+  // a missing file cannot be mapped, and leaves nothing to scan
+  MappedFile file;
+  check(!file.open(missing) && !file.is_open() && file.size() == 0,
+        "map a missing file");
+
+  Lexer lexer("left over");
+  add_tokens(lexer);
+  check(!lexer.input_file(missing) && lexer.at_end(), "lex a missing file");
+
+  LineScanner scanner("b+[0-9]");
+  size_t count = 7;
+  check(!scanner.count_file(missing, count) && count == 7,
+        "scan a missing file");
+
+  // files of every size from empty on
+  for (int i = 0; i < 50; i++) {
+    std::string contents = i ? random_input(rng, 5000, "ab09 \n") : "";
+    std::string path = temp_file(contents);
+
+    check(file.open(path) && file.is_open() && file.view() == contents,
+          "map a file of " + std::to_string(contents.length()) + " bytes");
+    file.close();
+
+    check(lexer.input_file(path) && same_tokens(lexer, contents),
+          "lex a file of " + std::to_string(contents.length()) + " bytes");
+    check(scanner.count_file(path, count) &&
+              count == scanner.count(contents),
+          "scan a file of " + std::to_string(contents.length()) + " bytes");
+
+    unlink(path.c_str());
+  }
+
+  // a file is not mapped for a lexer which would have to copy it
+  std::string path = temp_file("abc 123\n");
+  Lexer trees;
+  add_tokens(trees);
+  trees.add_token(4, new NeverNode());
+  check(!trees.input_file(path) && trees.at_end(), "lex a file as trees");
+  unlink(path.c_str());
+
+  return report("mapped_file_test");
+}
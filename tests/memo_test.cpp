@@ -0,0 +1,82 @@
+// File: tests/memo_test.cpp
+// Purpose: Check that the memo of a FlatRegex leaves its matches as the
+//          tree's, that it keeps nested alternatives from trying the same
+//          node at the same position over and over, and that the memory it
+//          holds after a long input is released.
+// Author: Robert Lowe
+#include "flat_regex.h"
+#include "lib.h"
+#include "test_util.h"
+
+// Alternatives nested depth deep, each repeating the one inside it. The
+// tree retries the inner ones from every position each outer one does.
+static std::string nested(int depth) {
+  std::string result = "a";
+  for (int i = 0; i < depth; i++) {
+    result = "(" + result + "|a)*b";
+  }
+  return result;
+}
+
+int main() {
+  std::mt19937 rng(18);
+
+  // patterns with a quantifier within a repeated node are memoized, and
+  // match and search as their trees do
+  std::vector<std::string> patterns = {nested(4), "((ab|a)+c?)*d",
+                                       "((a|b)+c)*x", "(x(ab|a)*)+y",
+                                       "((a|bc)+d?)*(x|y)"};
+  for (auto &pattern : patterns) {
+    RegexNode *tree = make_regex(pattern, REGEX_TREE);
+    FlatRegex *flat =
+        dynamic_cast<FlatRegex *>(make_regex(pattern, REGEX_FLAT));
+    check(flat && flat->memoized() && terminates(tree),
+          pattern + " is memoized");
+    for (int j = 0; j < 300 && flat; j++) {
+      std::string s = random_input(rng, 30, "aaabcdxy");
+      size_t start = rng() % (s.length() + 1);
+      size_t a = start, b = start, tree_start, tree_end, flat_start, flat_end;
+      bool matched = tree->match(s, a);
+      check(flat->match(s, b) == matched && (!matched || a == b),
+            "match " + pattern + " in '" + s + "'");
+      bool found = tree->search(s, start, tree_start, tree_end);
+      check(flat->search(s, start, flat_start, flat_end) == found &&
+                (!found ||
+                 (flat_start == tree_start && flat_end == tree_end)),
+            "search " + pattern + " in '" + s + "'");
+    }
+    delete tree;
+    delete flat;
+  }
+
+  // A simple pattern pays nothing
+  FlatRegex *simple =
+      dynamic_cast<FlatRegex *>(make_regex("(ab)*c", REGEX_FLAT));
+  check(simple && !simple->memoized(), "(ab)*c is not memoized");
+  delete simple;
+
+  // Nine levels deep, the tree takes minutes to search a thousand bytes.
+  // The memoized search finishes at once.
+  RegexNode *deep = make_regex(nested(9), REGEX_FLAT);
+  std::string s(1000, 'a');
+  size_t start, end;
+  check(!deep->search(s, 0, start, end), "search nine levels deep");
+
+  // A short input leaves the memo in place for the next. A long one grows
+  // it past what is kept, so it is released.
+  size_t pos, short_end = 0;
+  bool short_match = deep->match("aab", short_end);
+  size_t kept = FlatRegex::memo_bytes();
+  check(kept > 0 && kept <= FlatRegex::MEMO_KEEP_BYTES, "keep a small memo");
+  std::string long_input(4 << 20, 'c');
+  pos = 0;
+  check(!deep->match(long_input, pos), "match a long input");
+  check(FlatRegex::memo_bytes() <= kept, "release a large memo");
+  pos = 0;
+  check(deep->match("aab", pos) == short_match && pos == short_end &&
+            FlatRegex::memo_bytes() > 0,
+        "match after the release");
+  delete deep;
+
+  return report("memo_test");
+}
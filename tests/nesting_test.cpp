@@ -0,0 +1,81 @@
+// File: tests/nesting_test.cpp
+// Purpose: Check that parentheses nested as deep as the parser allows
+//          build and match in every mode on a 256 KB stack, and that deeper
+//          ones are refused.
+// Author: Robert Lowe
+#include <pthread.h>
+#include "lib.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// the pattern to build and the input it must match
+struct Job {
+  std::string pattern;
+  std::string input;
+  RegexOptions options;
+  bool built;
+  bool matched;
+};
+
+// build the pattern and match it against the whole input
+static void *run(void *arg) {
+  Job *job = (Job *)arg;
+  RegexNode *regex = make_regex(job->pattern, job->options);
+  size_t pos = 0;
+
+  job->built = regex != nullptr;
+  job->matched = regex && regex->match(job->input, pos) &&
+                 pos == job->input.length();
+  delete regex;
+  return nullptr;
+}
+
+// run the job on a thread with a 256 KB stack
+static void run_small(Job &job) {
+  pthread_attr_t attr;
+  pthread_t thread;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, 256 * 1024);
+  pthread_create(&thread, &attr, run, &job);
+  pthread_join(thread, nullptr);
+  pthread_attr_destroy(&attr);
+}
+
+int main() {
+  const char *closers[] = {")", ")*", ")?"};
+  const RegexMode modes[] = {REGEX_TREE, REGEX_NFA, REGEX_LAZY_DFA,
+                             REGEX_DFA, REGEX_FLAT};
+
+  for (auto closer : closers) {
+    for (size_t depth : {RegexParser::MAX_DEPTH, RegexParser::MAX_DEPTH + 1,
+                         (size_t)2000}) {
+      std::string pattern;
+      for (size_t i = 0; i < depth; i++) {
+        pattern += "(a";
+      }
+      for (size_t i = 0; i < depth; i++) {
+        pattern += closer;
+      }
+
+      for (auto mode : modes) {
+        for (int captures = 0; captures < 2; captures++) {
+          Job job{pattern, std::string(depth, 'a'), RegexOptions(mode),
+                  false, false};
+          job.options.captures = captures;
+          run_small(job);
+
+          std::string what = std::to_string(depth) + " deep with " +
+                             closer + " in mode " + std::to_string(mode);
+          if (depth <= RegexParser::MAX_DEPTH) {
+            check(job.built && job.matched, what);
+          } else {
+            check(!job.built, what);
+          }
+        }
+      }
+    }
+  }
+
+  return report("nesting_test");
+}
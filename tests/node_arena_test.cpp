@@ -0,0 +1,139 @@
+// File: tests/node_arena_test.cpp
+// Purpose: Check that trees placed in a NodeArena match as trees on the
+//          heap do, after the scope which placed them has ended, that
+//          nested scopes place nodes in the innermost arena, and that
+//          deleting a node runs its destructor but frees only heap nodes,
+//          which are allocated at their own size.
+// Author: Robert Lowe
+#include <cstdlib>
+#include <new>
+#include "character_node.h"
+#include "lib.h"
+#include "node_arena.h"
+#include "test_util.h"
+
+// the size of the last allocation by global operator new
+static size_t last_size = 0;
+
+// count the allocations of the whole program to see their sizes
+void *operator new(size_t size) {
+  last_size = size;
+  void *ptr = std::malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+// a node counting its destructions
+class CountedNode : public CharacterNode {
+public:
+  static int destroyed;
+  CountedNode() : CharacterNode('c') {}
+  virtual ~CountedNode() { destroyed++; }
+};
+
+int CountedNode::destroyed = 0;
+
+int main() {
+  std::mt19937 rng(14);
+
+  // A heap node is allocated at its own size, with nothing in front
+  delete new CountedNode();
+  last_size = 0;
+  RegexNode *heap = new CountedNode();
+  check(last_size == sizeof(CountedNode), "heap node size");
+  size_t pos = 0;
+  check(heap->match("c", pos) && pos == 1, "heap node");
+
+  // Trees parsed into an arena match as trees on the heap, after the
+  // scope of make_regex is gone and while the arena lives
+  const char *patterns[] = {"a(b|c)*x", "[a-c]+x?", "(ab)*c",  "a.b",
+                            "x[^a]*",   "(a|b)c",   "[^x]+a?", "abc"};
+  for (int i = 0; i < 64; i++) {
+    std::string pattern = patterns[i % 8];
+    NodeArena arena(i % 2 ? 64 : 4096);
+    RegexOptions options(REGEX_TREE);
+    options.arena = &arena;
+    RegexNode *placed = make_regex(pattern, options);
+    check(NodeArena::current() == nullptr, "no arena after make_regex");
+    check(placed && arena.used() > 0, "nodes placed in the arena");
+
+    size_t used = arena.used();
+    RegexNode *free_standing = make_regex(pattern, REGEX_TREE);
+    check(arena.used() == used, "nodes outside the arena");
+
+    for (int j = 0; j < 50; j++) {
+      std::string s = random_input(rng, 12, "abcx.");
+      size_t start = rng() % (s.length() + 1);
+      size_t a = start, b = start;
+      bool matched = placed->match(s, a);
+      check(matched == free_standing->match(s, b) && (!matched || a == b),
+            pattern + " in the arena on '" + s + "'");
+    }
+    delete placed;
+    delete free_standing;
+  }
+
+  // Nested scopes place nodes in the innermost arena, a null arena keeps
+  // the enclosing one, and the outer arena returns when the inner ends
+  NodeArena outer, inner;
+  {
+    NodeArena::Scope outer_scope(&outer);
+    RegexNode *a = new CountedNode();
+    {
+      NodeArena::Scope inner_scope(&inner);
+      check(NodeArena::current() == &inner, "inner scope");
+      RegexNode *b = new CountedNode();
+      {
+        NodeArena::Scope null_scope(nullptr);
+        check(NodeArena::current() == &inner, "null scope");
+      }
+      check(inner.used() == sizeof(CountedNode), "placed in the inner arena");
+      delete b;
+    }
+    check(NodeArena::current() == &outer, "back to the outer scope");
+    check(outer.used() == sizeof(CountedNode), "placed in the outer arena");
+    delete a;
+  }
+  check(NodeArena::current() == nullptr, "no scope");
+
+  // Deleting nodes in an arena runs their destructors, even outside its
+  // scope and between deletions of heap nodes
+  CountedNode::destroyed = 0;
+  NodeArena arena;
+  RegexNode *placed;
+  {
+    NodeArena::Scope scope(&arena);
+    placed = new CountedNode();
+  }
+  delete heap;
+  delete placed;
+  check(CountedNode::destroyed == 2, "destructors run");
+
+  // a heap node deleted while an arena is in scope is freed
+  heap = new CountedNode();
+  {
+    NodeArena::Scope scope(&arena);
+    delete heap;
+  }
+  check(CountedNode::destroyed == 3, "heap node deleted in a scope");
+
+  // a shared node in an arena is destroyed with its last reference
+  {
+    NodeArena::Scope scope(&arena);
+    placed = new CountedNode();
+  }
+  placed->ref();
+  RegexNode::unref(placed);
+  check(CountedNode::destroyed == 3 && placed->references() == 1,
+        "unref a shared arena node");
+  RegexNode::unref(placed);
+  check(CountedNode::destroyed == 4, "unref the last reference");
+
+  return report("node_arena_test");
+}
@@ -0,0 +1,151 @@
+// File: tests/node_builder_test.cpp
+// Purpose: Check the references a NodeBuilder keeps to shared subtrees,
+//          that a shared subtree outlives all but its last owner, and that
+//          the compiler, the flat regex and the reference matcher read
+//          trees with shared subtrees as if each were its own.
+// Author: Robert Lowe
+#include "flat_regex.h"
+#include "lib.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// the child at index i of a group, or nullptr
+static RegexNode *child(RegexNode *node, size_t i) {
+  GroupNode *group = dynamic_cast<GroupNode *>(node);
+  if (!group || i >= group->nodes().size()) {
+    return nullptr;
+  }
+  return group->nodes()[i];
+}
+
+// return true if the tree matches as the reference says it does
+static bool matches(RegexNode *tree, const std::string &s, size_t end) {
+  size_t pos = 0, expected;
+  bool matched = reference_match(tree, s, 0, expected);
+  return matched == (end != std::string::npos) &&
+         tree->match(s, pos) == matched && (!matched || pos == end);
+}
+
+int main() {
+  std::mt19937 rng(17);
+  NodeBuilder builder;
+  RegexParser parser;
+  parser.builder(&builder);
+
+  // Two trees share (ab)+, held by both parents and the builder. The
+  // roots themselves are not shared.
+  RegexNode *x = parser.parse("x(ab)+");
+  RegexNode *y = parser.parse("y(ab)+");
+  RegexNode *shared = child(x, 1);
+  check(x != y && x->references() == 1 && y->references() == 1, "roots");
+  check(shared && child(y, 1) == shared && shared->references() == 3,
+        "a subtree shared by two trees");
+
+  // it outlives the tree deleted first, and the builder's reference
+  delete x;
+  check(shared->references() == 2, "delete one owner");
+  check(matches(y, "yababa", 5), "match after deleting one owner");
+  builder.clear();
+  check(builder.size() == 0 && shared->references() == 1, "clear");
+  check(matches(y, "yab", 3) && matches(y, "xab", std::string::npos),
+        "match after clearing the builder");
+  delete y;
+
+  // Sharing the roots as well gives the callers one reference each
+  RegexNode *a = builder.share(parser.parse("[a-c]+x"));
+  RegexNode *b = builder.share(parser.parse("[a-c]+x"));
+  check(a == b && a->references() == 3, "share a root");
+  RegexNode::unref(a);
+  builder.clear();
+  check(b->references() == 1 && matches(b, "cabx", 4), "unshare a root");
+  RegexNode::unref(b);
+
+  // A subtree shared within one tree is flattened once, and compiled
+  // where each parent has it
+  RegexNode *twice = parser.parse("(ab)+x(ab)+");
+  RegexNode *unlike = parser.parse("(ab)+x(cd)+");
+  check(child(twice, 0) == child(twice, 2), "shared within a tree");
+  FlatRegex *flat_twice = FlatRegex::build(twice);
+  FlatRegex *flat_unlike = FlatRegex::build(unlike);
+  check(flat_twice->size() < flat_unlike->size(), "flatten a shared subtree");
+  NfaCompiler compiler;
+  Program *program = compiler.compile(twice);
+  PikeVM vm(program);
+  for (int j = 0; j < 300; j++) {
+    std::string s = random_input(rng, 12, "abx");
+    size_t tree_end = 0, flat_end = 0, vm_end, expected;
+    bool matched = reference_match(twice, s, 0, expected);
+    bool greedy = twice->match(s, tree_end);
+    check(flat_twice->match(s, flat_end) == greedy &&
+              (!greedy || flat_end == tree_end),
+          "flat match of a shared subtree on '" + s + "'");
+    check(vm.match(s, 0, vm_end) == matched &&
+              (!matched || vm_end == expected),
+          "compiled match of a shared subtree on '" + s + "'");
+  }
+  delete program;
+  delete flat_twice;
+  delete flat_unlike;
+  delete twice;
+  delete unlike;
+
+  // Many trees through one builder share what they can. Deleting half of
+  // them leaves the rest matching as they did, alone or compiled together.
+  std::vector<std::string> patterns;
+  std::vector<RegexNode *> trees;
+  for (int i = 0; i < 400; i++) {
+    patterns.push_back(random_pattern(rng));
+    trees.push_back(parser.parse(patterns.back()));
+  }
+  for (int i = 0; i < 400; i += 2) {
+    delete trees[i];
+    trees[i] = nullptr;
+  }
+  std::vector<RegexNode *> roots;
+  for (int i = 1; i < 400; i += 2) {
+    roots.push_back(trees[i]);
+    RegexNode *alone = make_regex(patterns[i], REGEX_NFA);
+    for (int j = 0; j < 10; j++) {
+      std::string s = random_input(rng, 12, "abcx.");
+      size_t end = 0, expected;
+      bool matched = reference_match(trees[i], s, 0, expected);
+      check(alone->match(s, end) == matched && (!matched || end == expected),
+            "shared " + patterns[i] + " on '" + s + "'");
+    }
+    delete alone;
+  }
+  check(builder.size() > 0, "the builder holds the shared subtrees");
+
+  // one program for all the rest, whose longest match has the smallest id
+  // of the trees matching that far
+  Program *all = compiler.compile(roots);
+  PikeVM any(all);
+  for (int j = 0; j < 100; j++) {
+    std::string s = random_input(rng, 12, "abcx.");
+    bool expected = false;
+    size_t expected_end = 0, end = 0;
+    int expected_id = -1, id = -1;
+    for (size_t k = 0; k < roots.size(); k++) {
+      if (reference_match(roots[k], s, 0, end) &&
+          (!expected || end > expected_end)) {
+        expected = true;
+        expected_end = end;
+        expected_id = k;
+      }
+    }
+    bool matched = any.match(s, 0, end, id);
+    check(matched == expected &&
+              (!matched || (end == expected_end && id == expected_id)),
+          "shared trees together on '" + s + "'");
+  }
+  delete all;
+
+  builder.clear();
+  for (auto tree : roots) {
+    delete tree;
+  }
+
+  return report("node_builder_test");
+}
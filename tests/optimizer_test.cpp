@@ -0,0 +1,118 @@
+// File: tests/optimizer_test.cpp
+// Purpose: Check that optimizing a parsed tree leaves its matches alone:
+//          the optimized tree matches as the tree as written, flattened so
+//          that it cannot loop, and both compile to programs which match
+//          alike.
+// Author: Robert Lowe
+#include "flat_regex.h"
+#include "lib.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// parse the pattern, optimized or as written
+static RegexNode *parse(const std::string &pattern, bool optimize) {
+  RegexParser parser;
+  parser.optimize(optimize);
+  return parser.parse(pattern);
+}
+
+// Compare the pattern optimized and as written on random inputs. Returns
+// false if the optimized tree might not finish.
+static bool compare(const std::string &pattern, std::mt19937 &rng,
+                    size_t length, const std::string &alphabet) {
+  RegexNode *written = parse(pattern, false);
+  RegexNode *optimized = parse(pattern, true);
+  FlatRegex *reference = FlatRegex::build(written);
+  bool finishes = terminates(optimized);
+
+  for (int j = 0; j < 20 && finishes; j++) {
+    std::string s = random_input(rng, length, alphabet);
+    size_t start = rng() % (s.length() + 1);
+    size_t a = start, b = start;
+    bool matched = reference->match(s, a);
+    check(optimized->match(s, b) == matched && (!matched || a == b),
+          "match " + pattern + " in '" + s + "' at " + std::to_string(start));
+  }
+
+  // the programs compiled from each match alike too
+  RegexNode *written_nfa = make_regex(written, REGEX_NFA);
+  RegexNode *optimized_nfa = make_regex(optimized, REGEX_NFA);
+  for (int j = 0; j < 20; j++) {
+    std::string s = random_input(rng, length, alphabet);
+    size_t a = 0, b = 0, start_a, end_a, start_b, end_b;
+    bool matched = written_nfa->match(s, a);
+    check(optimized_nfa->match(s, b) == matched && (!matched || a == b),
+          "compiled match " + pattern + " in '" + s + "'");
+    bool found = written_nfa->search(s, 0, start_a, end_a);
+    check(optimized_nfa->search(s, 0, start_b, end_b) == found &&
+              (!found || (start_a == start_b && end_a == end_b)),
+          "compiled search " + pattern + " in '" + s + "'");
+  }
+
+  delete reference;
+  delete written_nfa;
+  delete optimized_nfa;
+  return finishes;
+}
+
+// the number of nodes in the flattened tree of the pattern
+static size_t nodes(const std::string &pattern, bool optimize) {
+  RegexNode *tree = parse(pattern, optimize);
+  FlatRegex *flat = FlatRegex::build(tree);
+  size_t result = flat->size();
+  delete flat;
+  delete tree;
+  return result;
+}
+
+int main() {
+  std::mt19937 rng(16);
+
+  // random patterns, some of which optimize to trees which still loop
+  for (int i = 0; i < 2000; i++) {
+    compare(random_pattern(rng), rng, 16, "abcx.");
+  }
+
+  // Prefixes factored out of alternatives, alternatives which are
+  // prefixes of each other, optional repetitions, and a repetition of a
+  // repetition, which loops forever as written
+  const char *patterns[] = {"abc|abd", "(abc)|(abd)", "ab|a",    "(ab)|(a)",
+                            "(a+)?b",  "(a*)*",       "(a+)+b", "((ab)*)*c",
+                            "x(a*)+y", "(a?)*b"};
+  for (auto pattern : patterns) {
+    check(compare(pattern, rng, 30, "abcdxy"), pattern + std::string(" loops"));
+  }
+
+  // which leaves fewer nodes
+  check(nodes("(abc)|(abd)", true) < nodes("(abc)|(abd)", false),
+        "factor out a prefix");
+  check(nodes("(a*)*", true) < nodes("(a*)*", false), "collapse (a*)*");
+  check(nodes("abcdef", true) < nodes("abcdef", false), "literal run");
+
+  // (a*)* matches as a* does
+  RegexNode *tree = parse("(a*)*", true);
+  size_t pos = 0;
+  check(tree->match("aaab", pos) && pos == 3, "(a*)* on aaab");
+  delete tree;
+
+  // Where the tree as written loops, its flattened form stops repeating
+  // once it makes no progress, and a plus whose first repetition matches
+  // nothing still matches
+  struct {
+    const char *pattern, *s;
+    size_t end;
+  } loops[] = {{"(a?)+b", "b", 1},      {"(a?)+", "xy", 0},
+               {"(a*)*b", "aab", 3},    {"(b|a?)+c", "abc", 3},
+               {"(a?b?)+x", "abx", 3}};
+  for (auto &loop : loops) {
+    RegexNode *written = parse(loop.pattern, false);
+    FlatRegex *flat = FlatRegex::build(written);
+    size_t end = 0;
+    check(flat->match(loop.s, end) && end == loop.end,
+          loop.pattern + std::string(" flattened on ") + loop.s);
+    delete flat;
+    delete written;
+  }
+
+  return report("optimizer_test");
+}
@@ -0,0 +1,88 @@
+// File: tests/parallel_lexer_test.cpp
+// Purpose: Check the tokens of inputs lexed in many chunks on several
+//          threads against lexing them with one Lexer, splitting after
+//          newlines or where a predicate says, and check that verification
+//          catches a token crossing a split.
+// Author: Robert Lowe
+#include "lib.h"
+#include "parallel_lexer.h"
+#include "test_util.h"
+
+// the tokens of a small language, whose strings may hold newlines
+static void setup(Lexer &lexer) {
+  lexer.add_token(1, make_regex("[a-z]+", REGEX_TREE));
+  lexer.add_token(2, make_regex("[0-9]+", REGEX_TREE));
+  lexer.add_token(3, make_regex(" +", REGEX_TREE));
+  lexer.add_token(4, make_regex("\n", REGEX_TREE));
+  lexer.add_token(5, make_regex(";", REGEX_TREE));
+  lexer.add_token(6, make_regex("\"[^\"]*\"", REGEX_TREE));
+}
+
+// return true if the tokens are those of lexing the input with one lexer
+static bool same_tokens(const ParallelLexer::Tokens &tokens,
+                        const std::string &input) {
+  Lexer lexer(input);
+  setup(lexer);
+
+  size_t i = 0;
+  for (Lexer::Token t = lexer.next(); t.tok != Lexer::END_OF_INPUT;
+       t = lexer.next(), i++) {
+    if (i >= tokens.size() || tokens.tok[i] != t.tok ||
+        tokens.pos[i] != t.pos || tokens.len[i] != t.lexeme.length()) {
+      return false;
+    }
+  }
+  return i == tokens.size();
+}
+
+int main() {
+  std::mt19937 rng(11);
+  ParallelLexer lexer(setup, 4);
+  lexer.min_chunk(64);
+  lexer.verify(true);
+  check(lexer.threads() == 4, "threads");
+
+  // many chunks split after newlines, some of them empty lines
+  for (int i = 0; i < 50; i++) {
+    std::string input = random_input(rng, 20000, "abc 0123\n;");
+    ParallelLexer::Tokens tokens;
+    check(lexer.lex(input, tokens) && same_tokens(tokens, input),
+          "split after newlines, " + std::to_string(input.length()) +
+              " bytes");
+  }
+
+  // chunks split after semicolons instead
+  ParallelLexer semis(setup, 3);
+  semis.min_chunk(32);
+  semis.verify(true);
+  semis.sync_point(
+      [](std::string_view input, size_t pos) { return input[pos - 1] == ';'; });
+  for (int i = 0; i < 50; i++) {
+    std::string input = random_input(rng, 20000, "abc 0123\n;;");
+    ParallelLexer::Tokens tokens;
+    check(semis.lex(input, tokens) && same_tokens(tokens, input),
+          "split after semicolons, " + std::to_string(input.length()) +
+              " bytes");
+  }
+
+  // A string of many lines crosses a split, so some chunk begins inside
+  // the string. Verification finds the tokens differ.
+  std::string input;
+  for (int line = 0; line < 200; line++) {
+    input += "abc 123 de\n";
+  }
+  input += "\"";
+  for (int line = 0; line < 200; line++) {
+    input += "a string\n";
+  }
+  input += "\" 42\n";
+  ParallelLexer::Tokens tokens;
+  check(!lexer.lex(input, tokens), "verify a string across a split");
+
+  // without verification the split goes unnoticed
+  lexer.verify(false);
+  check(lexer.lex(input, tokens) && !same_tokens(tokens, input),
+        "a string across a split");
+
+  return report("parallel_lexer_test");
+}
@@ -0,0 +1,91 @@
+// File: tests/pike_vm_test.cpp
+// Purpose: Check the Pike VM against the reference matcher on random
+//          patterns and inputs.
+// Author: Robert Lowe
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+int main() {
+  std::mt19937 rng(1);
+
+  for (int i = 0; i < 2000; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    check(program, "compile " + pattern);
+    if (!program) {
+      delete tree;
+      continue;
+    }
+    PikeVM vm(program);
+
+    for (int j = 0; j < 20; j++) {
+      std::string s = random_input(rng, 12);
+      size_t pos = rng() % (s.length() + 1);
+      std::string what = pattern + " on '" + s + "' at " +
+                         std::to_string(pos);
+
+      size_t end = 0, expected_end = 0;
+      bool matched = vm.match(s, pos, end);
+      bool expected = reference_match(tree, s, pos, expected_end);
+      check(matched == expected && (!matched || end == expected_end),
+            "match " + what);
+
+      size_t start = 0, expected_start = 0;
+      matched = vm.search(s, pos, start, end);
+      expected = reference_search(tree, s, pos, expected_start, expected_end);
+      check(matched == expected &&
+                (!matched || (start == expected_start && end == expected_end)),
+            "search " + what);
+    }
+
+    delete program;
+    delete tree;
+  }
+
+  // several roots report the smallest id of those with the longest match
+  for (int i = 0; i < 500; i++) {
+    std::vector<RegexNode *> roots;
+    RegexParser parser;
+    for (int k = 0; k < 3; k++) {
+      roots.push_back(parser.parse(random_pattern(rng)));
+    }
+    NfaCompiler compiler;
+    Program *program = compiler.compile(roots);
+    PikeVM vm(program);
+
+    for (int j = 0; j < 20; j++) {
+      std::string s = random_input(rng, 12);
+      bool expected = false;
+      size_t expected_end = 0;
+      int expected_id = -1;
+      for (int k = 0; k < 3; k++) {
+        size_t end;
+        if (reference_match(roots[k], s, 0, end) &&
+            (!expected || end > expected_end)) {
+          expected = true;
+          expected_end = end;
+          expected_id = k;
+        }
+      }
+
+      size_t end = 0;
+      int id = -1;
+      bool matched = vm.match(s, 0, end, id);
+      check(matched == expected &&
+                (!matched || (end == expected_end && id == expected_id)),
+            "ids on '" + s + "'");
+    }
+
+    delete program;
+    for (auto root : roots) {
+      delete root;
+    }
+  }
+
+  return report("pike_vm_test");
+}
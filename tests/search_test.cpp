@@ -0,0 +1,135 @@
+// File: tests/search_test.cpp
+// Purpose: Check the one-pass searches of the DFAs against trying an
+//          anchored match at every position, on inputs long enough for
+//          several matches to be under way at once.
+// Author: Robert Lowe
+#include "dfa.h"
+#include "lazy_dfa.h"
+#include "lib.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "program_node.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+// find the leftmost-longest match by an anchored match at every position
+static bool naive_search(PikeVM &vm, const std::string &s, size_t pos,
+                         size_t &start, size_t &end) {
+  for (; pos <= s.length(); pos++) {
+    if (vm.match(s, pos, end)) {
+      start = pos;
+      return true;
+    }
+  }
+  return false;
+}
+
+// compare a search with the naive one
+static void compare(Matcher &matcher, PikeVM &vm, const std::string &what,
+                    const std::string &s, size_t pos) {
+  size_t start = 0, end = 0, expected_start = 0, expected_end = 0;
+  bool matched = matcher.search(s, pos, start, end);
+  bool expected = naive_search(vm, s, pos, expected_start, expected_end);
+  check(matched == expected &&
+            (!matched || (start == expected_start && end == expected_end)),
+        what + " on '" + s + "' at " + std::to_string(pos));
+}
+
+int main() {
+  std::mt19937 rng(4);
+
+  for (int i = 0; i < 1500; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+
+    PikeVM vm(program);
+    Dfa *dfa = Dfa::build(program);
+    LazyDfa lazy(program);
+    LazyDfa small(program, 1500);
+    for (int j = 0; j < 10; j++) {
+      std::string s = random_input(rng, 60);
+      size_t pos = rng() % (s.length() + 1);
+      if (dfa) {
+        compare(*dfa, vm, "dfa " + pattern, s, pos);
+      }
+      compare(lazy, vm, "lazy dfa " + pattern, s, pos);
+      compare(small, vm, "small lazy dfa " + pattern, s, pos);
+    }
+    delete dfa;
+    delete program;
+  }
+
+  // Without a match, trying every position takes quadratic time. These
+  // finish at once when each search is one pass.
+  std::string s(200000, 'a');
+  const char *patterns[] = {"a*b", "(a|b)*c", "a*ba|a"};
+  for (auto pattern : patterns) {
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+
+    Dfa *dfa = Dfa::build(program);
+    LazyDfa lazy(program);
+    size_t start = 0, end = 0;
+    check(dfa && !dfa->search(s, 0, start, end),
+          std::string("dfa ") + pattern + " on a long input");
+    check(!lazy.search(s, 0, start, end),
+          std::string("lazy dfa ") + pattern + " on a long input");
+    delete dfa;
+    delete program;
+  }
+
+  // A literal prefix only says where the search begins. Trying a match at
+  // each occurrence would be quadratic here, as every byte is one.
+  const RegexMode modes[] = {REGEX_NFA, REGEX_LAZY_DFA, REGEX_DFA};
+  for (auto mode : modes) {
+    RegexNode *regex = make_regex("a[^z]*z", mode);
+    size_t start = 0, end = 0;
+    check(!regex->search(s, 0, start, end),
+          "prefixed regex in mode " + std::to_string(mode) +
+              " on a long input");
+    delete regex;
+  }
+
+  // and the prefixed searches still find what the naive one does
+  for (int i = 0; i < 300; i++) {
+    std::string pattern = "a" + random_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+    PikeVM vm(program);
+
+    for (auto mode : modes) {
+      ProgramNode *regex = dynamic_cast<ProgramNode *>(make_regex(pattern,
+                                                                  mode));
+      check(regex != nullptr, "compile " + pattern);
+      for (int j = 0; regex && j < 10; j++) {
+        std::string s = random_input(rng, 60);
+        size_t pos = rng() % (s.length() + 1);
+        compare(*regex->matcher(), vm,
+                "mode " + std::to_string(mode) + " " + pattern, s, pos);
+
+        size_t start = 0, end = 0, expected_start = 0, expected_end = 0;
+        bool found = regex->find(s, pos, start, end);
+        bool expected = naive_search(vm, s, pos, expected_start,
+                                     expected_end);
+        check(found == expected &&
+                  (!found || (start == expected_start && end == expected_end)),
+              "find " + pattern + " on '" + s + "' at " +
+                  std::to_string(pos));
+      }
+      delete regex;
+    }
+    delete program;
+  }
+
+  return report("search_test");
+}
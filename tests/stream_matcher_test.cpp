@@ -0,0 +1,122 @@
+// File: tests/stream_matcher_test.cpp
+// Purpose: Check the matches found in a stream fed in random chunks against
+//          those found when it is fed whole, and against repeated searches
+//          of the whole input by the Pike VM.
+// Author: Robert Lowe
+#include "stream_matcher.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "test_util.h"
+
+typedef std::vector<std::pair<size_t, size_t>> Matches;
+
+// Feed the input in chunks of random sizes, or whole if max_chunk is 0,
+// draining the queue after each
+static Matches feed(StreamMatcher &matcher, const std::string &s,
+                    size_t max_chunk, std::mt19937 &rng) {
+  Matches matches;
+  size_t start, end;
+
+  matcher.reset();
+  for (size_t p = 0; p < s.length();) {
+    size_t n = max_chunk ? 1 + rng() % max_chunk : s.length();
+    p += matcher.feed(std::string_view(s).substr(p, n));
+    while (matcher.next_match(start, end)) {
+      matches.push_back(std::make_pair(start, end));
+    }
+  }
+  matcher.finish();
+  while (matcher.next_match(start, end)) {
+    matches.push_back(std::make_pair(start, end));
+  }
+
+  return matches;
+}
+
+// Search the whole input again after each match. An empty match at a
+// position rules out any other match beginning there.
+static Matches search_all(PikeVM &vm, const std::string &s) {
+  Matches matches;
+  size_t pos = 0, empty_at = std::string::npos;
+  size_t start, end;
+
+  while (pos <= s.length()) {
+    if (pos == empty_at) {
+      pos++;
+      continue;
+    }
+    if (!vm.search(s, pos, start, end)) {
+      break;
+    }
+    matches.push_back(std::make_pair(start, end));
+    pos = end;
+    empty_at = start == end ? end : std::string::npos;
+  }
+
+  return matches;
+}
+
+int main() {
+  std::mt19937 rng(6);
+
+  for (int i = 0; i < 1500; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+    PikeVM vm(program);
+
+    StreamMatcher matcher(pattern);
+    StreamMatcher held(pattern, 4);
+    StreamMatcher queued(pattern, StreamMatcher::DEFAULT_MAX_PENDING, 2);
+    check(matcher.valid(), "compile " + pattern);
+
+    for (int j = 0; j < 10; j++) {
+      std::string s = random_input(rng, 40);
+      std::string what = pattern + " on '" + s + "'";
+
+      Matches whole = feed(matcher, s, 0, rng);
+      check(whole == search_all(vm, s), "whole " + what);
+      check(feed(matcher, s, 1, rng) == whole, "bytes " + what);
+      check(feed(matcher, s, 7, rng) == whole, "chunks " + what);
+      check(feed(queued, s, 0, rng) == whole, "short queue " + what);
+
+      // holding back at most a few bytes changes the matches, but not
+      // with the chunks
+      check(feed(held, s, 3, rng) == feed(held, s, 0, rng),
+            "held back " + what);
+    }
+    delete program;
+  }
+
+  // A caller which never drains the queue finds scanning stopped once it
+  // is full, and picks up where it left off after draining it
+  StreamMatcher matcher("a", StreamMatcher::DEFAULT_MAX_PENDING, 3);
+  std::string s(10000, 'a');
+  size_t n = matcher.feed(s);
+  check(n < s.length() && matcher.feed(std::string_view(s).substr(n)) == 0,
+        "a full queue");
+
+  size_t count = 0, start, end;
+  for (;;) {
+    while (matcher.next_match(start, end)) {
+      check(start == count && end == count + 1, "match " +
+                                                     std::to_string(count));
+      count++;
+    }
+    if (n == s.length()) {
+      break;
+    }
+    n += matcher.feed(std::string_view(s).substr(n));
+  }
+  matcher.finish();
+  while (matcher.next_match(start, end)) {
+    count++;
+  }
+  check(count == s.length(), "all the matches after draining");
+
+  return report("stream_matcher_test");
+}
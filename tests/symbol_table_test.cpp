@@ -0,0 +1,94 @@
+// File: tests/symbol_table_test.cpp
+// Purpose: Check a SymbolTable against a map from strings to their order
+//          of arrival, and the symbols a Lexer interns against the lexemes
+//          it finds without interning.
+// Author: Robert Lowe
+#include <unordered_map>
+#include "lexer.h"
+#include "lib.h"
+#include "symbol_table.h"
+#include "test_util.h"
+
+// the tokens of a small language with many repeated identifiers
+static void add_tokens(Lexer &lexer) {
+  lexer.add_token(1, make_regex("[a-d]+", REGEX_TREE));
+  lexer.add_token(2, make_regex("[0-9]+", REGEX_TREE));
+  lexer.add_token(3, make_regex(" +", REGEX_TREE));
+}
+
+int main() {
+  std::mt19937 rng(13);
+
+  // Short strings which recur, strings holding zero bytes, the empty
+  // string, and strings too long to share an arena block
+  SymbolTable table;
+  std::unordered_map<std::string, int> expected;
+  std::vector<std::string_view> names;
+  for (int i = 0; i < 50000; i++) {
+    std::string s = random_input(rng, i % 100 == 0 ? 20000 : 6,
+                                 std::string("abc\0", 4));
+    int symbol = table.intern(s);
+    auto found = expected.find(s);
+    if (found == expected.end()) {
+      check(symbol == (int)expected.size(), "new symbol for '" + s + "'");
+      expected[s] = symbol;
+      names.push_back(table.name(symbol));
+    } else {
+      check(symbol == found->second, "old symbol for '" + s + "'");
+    }
+  }
+  check(table.size() == expected.size(), "size");
+  for (auto &entry : expected) {
+    check(table.find(entry.first) == entry.second &&
+              names[entry.second] == entry.first &&
+              table.name(entry.second) == entry.first,
+          "name of '" + entry.first + "'");
+  }
+  check(table.find("not in the table") == -1, "find a missing string");
+
+  // An interning lexer gives each token the symbol of its lexeme, which a
+  // Token no longer copies
+  for (int i = 0; i < 100; i++) {
+    std::string s = random_input(rng, 200, "abcd012 ");
+    SymbolTable symbols;
+    Lexer plain(s), interning(s), batched(s);
+    add_tokens(plain);
+    add_tokens(interning);
+    add_tokens(batched);
+    interning.intern(&symbols);
+    batched.intern(&symbols);
+
+    bool same = true;
+    std::vector<int> expected_tok, expected_symbol;
+    for (Lexer::Token t = plain.next(); t.tok != Lexer::END_OF_INPUT;
+         t = plain.next()) {
+      Lexer::Token u = interning.next();
+      same = same && t.symbol == -1 && u.tok == t.tok && u.pos == t.pos &&
+             u.lexeme.empty() && u.symbol >= 0 &&
+             symbols.name(u.symbol) == t.lexeme;
+      expected_tok.push_back(u.tok);
+      expected_symbol.push_back(u.symbol);
+    }
+    check(same && interning.next().tok == Lexer::END_OF_INPUT,
+          "interned tokens of '" + s + "'");
+
+    // the batches of symbols hold the same
+    int tok[7], symbol[7];
+    size_t count;
+    std::vector<int> got_tok, got_symbol;
+    while ((count = batched.next_symbols(tok, symbol, 7)) > 0) {
+      got_tok.insert(got_tok.end(), tok, tok + count);
+      got_symbol.insert(got_symbol.end(), symbol, symbol + count);
+    }
+    check(got_tok == expected_tok && got_symbol == expected_symbol,
+          "symbol batches of '" + s + "'");
+  }
+
+  // batches of symbols need a table
+  Lexer untabled("abc");
+  add_tokens(untabled);
+  int tok, symbol;
+  check(untabled.next_symbols(&tok, &symbol, 1) == 0, "no table");
+
+  return report("symbol_table_test");
+}
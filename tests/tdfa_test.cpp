@@ -0,0 +1,65 @@
+// File: tests/tdfa_test.cpp
+// Purpose: Check the capture slots found by the tagged DFA against those of
+//          the Pike VM and the backtracker.
+// Author: Robert Lowe
+#include "backtracker.h"
+#include "nfa_compiler.h"
+#include "pike_vm.h"
+#include "regex_parser.h"
+#include "tdfa.h"
+#include "test_util.h"
+
+int main() {
+  std::mt19937 rng(8);
+  size_t built = 0;
+
+  for (int i = 0; i < 2000; i++) {
+    std::string pattern = random_pattern(rng);
+    RegexParser parser;
+    parser.captures(true);
+    RegexNode *tree = parser.parse(pattern);
+    NfaCompiler compiler;
+    Program *program = compiler.compile(tree);
+    delete tree;
+
+    Tdfa *tdfa = Tdfa::build(program);
+    PikeVM vm(program);
+    Backtracker bt(program);
+    if (!tdfa) {
+      delete program;
+      continue;
+    }
+    built++;
+
+    for (int j = 0; j < 20; j++) {
+      std::string s = random_input(rng, 12);
+      size_t pos = rng() % (s.length() + 1);
+      std::string what = pattern + " on '" + s + "' at " +
+                         std::to_string(pos);
+
+      // the tagged dfa only matches the whole input
+      std::vector<size_t> slots, expected_slots, bt_slots;
+      size_t end = 0;
+      bool whole = vm.match(s, pos, end) && end == s.length();
+      bool matched = tdfa->match(s, pos, slots);
+      check(matched == whole, "match " + what);
+
+      // so the others are given the input up to where their match ends
+      if (vm.match(s, pos, end)) {
+        std::string_view prefix(s.data(), end);
+        matched = tdfa->match(prefix, pos, slots);
+        vm.match(prefix, pos, expected_slots);
+        bt.match(prefix, pos, bt_slots);
+        check(matched && slots == expected_slots,
+              "captures against the vm " + what);
+        check(slots == bt_slots, "captures against the backtracker " + what);
+      }
+    }
+
+    delete tdfa;
+    delete program;
+  }
+
+  check(built > 1000, "too few tagged dfas were built");
+  return report("tdfa_test");
+}
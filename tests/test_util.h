@@ -0,0 +1,213 @@
+// File: tests/test_util.h
+// Purpose: Helpers shared by the differential tests: random patterns and
+//          inputs, a reference matcher which reads the parsed tree
+//          directly, and a failure counter.
+// Author: Robert Lowe
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "byte_set.h"
+#include "regex.h"
+
+// the number of failed checks so far
+inline int &failures() {
+  static int count = 0;
+  return count;
+}
+
+// Record a failed check unless ok, printing the first few
+inline void check(bool ok, const std::string &what) {
+  if (!ok && failures()++ < 10) {
+    std::cout << "FAIL: " << what << std::endl;
+  }
+}
+
+// report the result of a test program, returning its exit status
+inline int report(const std::string &name) {
+  std::cout << name << ": " << (failures() ? "FAILED" : "ok") << " ("
+            << failures() << " failures)" << std::endl;
+  return failures() ? 1 : 0;
+}
+
+// A random pattern of up to four matches, each one an atom or, above the
+// given depth, a parenthesized pattern, optionally quantified or followed
+// by an alternative.
+inline std::string random_pattern(std::mt19937 &rng, int depth = 0) {
+  static const char *atoms[] = {"a", "b", "c",     ".",   "[ab]",
+                                "[^a]", "[a-c]", "\\.", "x"};
+  std::string result;
+  int n = 1 + rng() % 4;
+
+  for (int i = 0; i < n; i++) {
+    std::string match;
+    if (rng() % 10 < 6 || depth > 2) {
+      match = atoms[rng() % 9];
+    } else {
+      match = "(" + random_pattern(rng, depth + 1) + ")";
+    }
+
+    int q = rng() % 6;
+    if (q == 0) {
+      match += "*";
+    } else if (q == 1) {
+      match += "+";
+    } else if (q == 2) {
+      match += "?";
+    } else if (q == 3 && i + 1 < n) {
+      match += "|";
+    }
+    result += match;
+  }
+
+  return result;
+}
+
+// a random string of up to max_length bytes from the alphabet
+inline std::string random_input(std::mt19937 &rng, size_t max_length,
+                                const std::string &alphabet = "abcx.") {
+  std::string result;
+  size_t n = rng() % (max_length + 1);
+  for (size_t i = 0; i < n; i++) {
+    result += alphabet[rng() % alphabet.length()];
+  }
+  return result;
+}
+
+// Mark in ends every position where a match of node beginning at one of
+// the positions marked in starts can end. Every way of matching counts, so
+// this is the language of the node rather than what any engine prefers.
+inline std::vector<bool> reference_ends(RegexNode *node, const std::string &s,
+                                        const std::vector<bool> &starts) {
+  std::vector<bool> ends(s.length() + 1, false);
+  ByteSet set;
+
+  if (node->byte_set(set)) {
+    for (size_t p = 0; p < s.length(); p++) {
+      ends[p + 1] = starts[p] && set.contains(s[p]);
+    }
+  } else if (LiteralNode *literal = dynamic_cast<LiteralNode *>(node)) {
+    std::string text(literal->text());
+    for (size_t p = 0; p + text.length() <= s.length(); p++) {
+      ends[p + text.length()] = starts[p] && s.compare(p, text.length(),
+                                                        text) == 0;
+    }
+  } else if (GroupNode *group = dynamic_cast<GroupNode *>(node)) {
+    ends = starts;
+    for (auto child : group->nodes()) {
+      ends = reference_ends(child, s, ends);
+    }
+  } else if (OrNode *alt = dynamic_cast<OrNode *>(node)) {
+    for (auto child : alt->nodes()) {
+      std::vector<bool> some = reference_ends(child, s, starts);
+      for (size_t p = 0; p <= s.length(); p++) {
+        ends[p] = ends[p] || some[p];
+      }
+    }
+  } else if (CaptureNode *capture = dynamic_cast<CaptureNode *>(node)) {
+    ends = reference_ends(capture->node(), s, starts);
+  } else {
+    // the quantifiers, repeated until no new end turns up
+    RegexNode *child = nullptr;
+    bool empty = true, repeat = true;
+    if (ZeroNode *zero = dynamic_cast<ZeroNode *>(node)) {
+      child = zero->node();
+    } else if (OneNode *one = dynamic_cast<OneNode *>(node)) {
+      child = one->node();
+      empty = false;
+    } else if (OptionalNode *opt = dynamic_cast<OptionalNode *>(node)) {
+      child = opt->node();
+      repeat = false;
+    }
+
+    std::vector<bool> frontier = reference_ends(child, s, starts);
+    ends = frontier;
+    while (repeat) {
+      frontier = reference_ends(child, s, frontier);
+      bool grew = false;
+      for (size_t p = 0; p <= s.length(); p++) {
+        if (frontier[p] && !ends[p]) {
+          ends[p] = grew = true;
+        }
+      }
+      if (!grew) {
+        break;
+      }
+    }
+    for (size_t p = 0; empty && p <= s.length(); p++) {
+      ends[p] = ends[p] || starts[p];
+    }
+  }
+
+  return ends;
+}
+
+// The end of the longest match of the tree beginning at pos, if any
+inline bool reference_match(RegexNode *tree, const std::string &s,
+                            size_t pos, size_t &end) {
+  std::vector<bool> starts(s.length() + 1, false);
+  starts[pos] = true;
+  std::vector<bool> ends = reference_ends(tree, s, starts);
+
+  for (size_t p = s.length() + 1; p > pos; p--) {
+    if (ends[p - 1]) {
+      end = p - 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+// The leftmost-longest match of the tree at or after pos, if any
+inline bool reference_search(RegexNode *tree, const std::string &s,
+                             size_t pos, size_t &start, size_t &end) {
+  for (; pos <= s.length(); pos++) {
+    if (reference_match(tree, s, pos, end)) {
+      start = pos;
+      return true;
+    }
+  }
+  return false;
+}
+
+// True if the tree always finishes a match. The tree repeats a node for as
+// long as it matches, so a repeated node which may match nothing repeats
+// forever, where a flat regex stops for want of progress.
+inline bool terminates(RegexNode *node) {
+  ByteSet set;
+  RegexNode *child = nullptr;
+
+  if (GroupNode *group = dynamic_cast<GroupNode *>(node)) {
+    for (auto n : group->nodes()) {
+      if (!terminates(n)) {
+        return false;
+      }
+    }
+  } else if (OrNode *alt = dynamic_cast<OrNode *>(node)) {
+    for (auto n : alt->nodes()) {
+      if (!terminates(n)) {
+        return false;
+      }
+    }
+  } else if (ZeroNode *zero = dynamic_cast<ZeroNode *>(node)) {
+    child = zero->node();
+    if (child->first_bytes(set)) {
+      return false;
+    }
+  } else if (OneNode *one = dynamic_cast<OneNode *>(node)) {
+    child = one->node();
+    if (child->first_bytes(set)) {
+      return false;
+    }
+  } else if (OptionalNode *opt = dynamic_cast<OptionalNode *>(node)) {
+    child = opt->node();
+  } else if (InverseNode *inv = dynamic_cast<InverseNode *>(node)) {
+    child = inv->node();
+  }
+
+  return !child || terminates(child);
+}
+
+#endif
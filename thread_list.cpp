@@ -0,0 +1,15 @@
+// File: thread_list.cpp
+// Purpose: An ordered set of program addresses, used by the automata to hold
+//          the threads of a simulated NFA.
+// Author: Robert Lowe
+#include "thread_list.h"
+
+// construct a list able to hold the addresses of a program of size n
+ThreadList::ThreadList(int n) : _size(0) { resize(n); }
+
+// resize the list for a program of size n, and clear it
+void ThreadList::resize(int n) {
+  _dense.assign(n, 0);
+  _sparse.assign(n, 0);
+  _size = 0;
+}
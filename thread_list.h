@@ -0,0 +1,45 @@
+// File: thread_list.h
+// Purpose: An ordered set of program addresses, used by the automata to hold
+//          the threads of a simulated NFA.
+// Author: Robert Lowe
+#ifndef THREAD_LIST_H
+#define THREAD_LIST_H
+#include <vector>
+
+// An ordered set of program addresses with constant time insertion,
+// membership and clearing.
+class ThreadList {
+public:
+  // construct a list able to hold the addresses of a program of size n
+  ThreadList(int n = 0);
+
+  // resize the list for a program of size n, and clear it
+  void resize(int n);
+
+  // remove every address from the list
+  void clear() { _size = 0; }
+
+  // return true if pc is in the list
+  bool contains(int pc) const {
+    unsigned i = _sparse[pc];
+    return i < _size && _dense[i] == pc;
+  }
+
+  // add pc to the end of the list
+  void add(int pc) {
+    _sparse[pc] = _size;
+    _dense[_size++] = pc;
+  }
+
+  // the number of addresses in the list, and the address at index i
+  unsigned size() const { return _size; }
+  bool empty() const { return _size == 0; }
+  int operator[](unsigned i) const { return _dense[i]; }
+
+private:
+  std::vector<int> _dense;
+  std::vector<unsigned> _sparse;
+  unsigned _size;
+};
+
+#endif
@@ -2,6 +2,7 @@
 // Purpose: Wildcard matching
 // Author: Robert Lowe
 #include "wildcard_node.h"
+#include "byte_set.h"
 #include <string>
 
 // Attempt to match a wilcard pattern start position pos
@@ -13,3 +14,9 @@ bool WildcardNode::match(const std::string &str, size_t &pos) {
 
   return false;
 }
+
+// a wildcard matches the set of all bytes
+bool WildcardNode::byte_set(ByteSet &set) {
+  set.fill();
+  return true;
+}
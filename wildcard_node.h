@@ -11,5 +11,8 @@ public:
 
   // Attempt to match a wilcard pattern start position pos
   virtual bool match(const std::string &str, size_t &pos);
+
+  // a wildcard matches the set of all bytes
+  virtual bool byte_set(ByteSet &set);
 };
 #endif
\ No newline at end of file
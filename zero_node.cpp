@@ -2,18 +2,29 @@
 // Purpose: The zero node matches zero or more occurrences of its child node.
 // Author: Robert Lowe
 #include "zero_node.h"
+#include "class_node.h"
+#include "nfa_compiler.h"
 #include <string>
 
 // Construct a zero node with the node to repeat
-ZeroNode::ZeroNode(RegexNode *node) : _node(node) {}
+ZeroNode::ZeroNode(RegexNode *node)
+    : _node(node), _class(dynamic_cast<ClassNode *>(node)) {}
 
 // Destruct a zero node
 ZeroNode::~ZeroNode() {
-  delete _node;
+  RegexNode::unref(_node);
 }
 
 // Attempt to match the string beginning at the given position
 bool ZeroNode::match(const std::string &str, size_t &pos) {
+  // a class can skip the whole run at once
+  if (_class) {
+    if (pos < str.length()) {
+      pos += _class->span(str.data() + pos, str.length() - pos);
+    }
+    return true;
+  }
+
   // Keep attempting to match the node as many times as possible
   while (_node->match(str, pos)) {
     // Continue matching
@@ -22,3 +33,35 @@ bool ZeroNode::match(const std::string &str, size_t &pos) {
   // Zero or more matches always succeed
   return true;
 }
+
+// Compile zero or more repetitions:
+//   L1: split L2, end
+//   L2: <node>
+//       jmp L1
+//  end:
+bool ZeroNode::compile(NfaCompiler &compiler) {
+  int split = compiler.emit_split(compiler.pc() + 1, -1);
+  if (!compiler.compile_node(_node)) {
+    return false;
+  }
+  compiler.emit_jmp(split);
+  compiler.patch_y(split, compiler.pc());
+  return true;
+}
+
+// Zero repetitions begin like the node, and may be empty.
+bool ZeroNode::first_bytes(ByteSet &set) {
+  _node->first_bytes(set);
+  return true;
+}
+
+// retrieve the node to repeat
+RegexNode *ZeroNode::node() const { return _node; }
+
+// give up the node without deleting it
+RegexNode *ZeroNode::release() {
+  RegexNode *result = _node;
+  _node = nullptr;
+  _class = nullptr;
+  return result;
+}